@@ -1,6 +1,133 @@
+#include "scenario.h"
+
+#include <fstream>
 #include <iostream>
+#include <string>
+
+#if defined(__linux__)
+#include "bot_client.h"
+#include "server.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#endif
+
+namespace {
+  auto CompileScenario(char const* text_path, char const* binary_path) -> int {
+    auto text = std::ifstream{text_path};
+    if (!text) {
+      std::cerr << "Cannot open " << text_path << std::endl;
+      return 1;
+    }
+    auto const compiled = scenario::Compile(text);
+
+    auto binary = std::ofstream{binary_path, std::ios::binary};
+    scenario::Write(binary, compiled);
+    if (!binary) {
+      std::cerr << "Cannot write " << binary_path << std::endl;
+      return 1;
+    }
+    std::cout << "Compiled " << compiled.kinds.size() << " kinds and "
+        << compiled.units.size() << " units" << std::endl;
+    return 0;
+  }
+
+#if defined(__linux__)
+  auto Argument(int argc, char const* argv[], int index, int fallback) -> int {
+    return index < argc ? std::stoi(argv[index]) : fallback;
+  }
+
+
+  auto Print(net::ServerStats const& stats, std::chrono::duration<double> elapsed) {
+    std::cout
+        << "ticks:             " << stats.ticks << " (" << stats.overruns << " overruns)\n"
+        << "datagrams in/out:  " << stats.datagrams_received << " / " << stats.datagrams_sent << "\n"
+        << "commands applied:  " << stats.commands_applied
+        << " (" << stats.commands_rejected << " rejected)\n"
+        << "commands/sec:      " << stats.commands_applied / elapsed.count() << "\n"
+        << "tick jitter:       mean " << stats.mean_tick_jitter.count()
+        << "us, max " << stats.max_tick_jitter.count() << "us" << std::endl;
+  }
+#endif
+
+
+  auto Usage() -> int {
+    std::cout
+        << "Usage:\n"
+        << "  QuaRTS compile-scenario <scenario.txt> <scenario.bin>\n"
+#if defined(__linux__)
+        << "  QuaRTS server [port] [games]\n"
+        << "  QuaRTS bots <port> [bots] [seconds] [commands/sec per bot]\n"
+        << "  QuaRTS loadtest [bots] [seconds] [commands/sec per bot]\n"
+#endif
+        << std::flush;
+    return 1;
+  }
+}
+
+
+auto main(int argc, char const* argv[]) -> int {
+  if (argc < 2) {
+    return Usage();
+  }
+  auto const mode = std::string{argv[1]};
+
+  if (mode == "compile-scenario" && argc == 4) {
+    return CompileScenario(argv[2], argv[3]);
+  }
+
+#if defined(__linux__)
+  using namespace std::chrono;
+
+  if (mode == "server") {
+    auto config = net::ServerConfig{};
+    config.address = "0.0.0.0";
+    config.port = static_cast<std::uint16_t>(Argument(argc, argv, 2, 7777));
+    config.games = Argument(argc, argv, 3, 1);
+    auto server = net::Server{config};
+    std::cout << "Serving " << config.games << " game(s) on port " << server.port() << std::endl;
+    server.run();
+    return 0;
+  }
+
+  if (mode == "bots" && argc > 2) {
+    auto config = net::BotConfig{};
+    config.server_port = static_cast<std::uint16_t>(Argument(argc, argv, 2, 0));
+    config.bots = Argument(argc, argv, 3, 8);
+    config.commands_per_second = Argument(argc, argv, 5, 20);
+    auto swarm = net::BotSwarm{config};
+    swarm.run_for(seconds{Argument(argc, argv, 4, 10)});
+    auto const stats = swarm.stats();
+    std::cout << stats.joined << " bots joined, sent " << stats.commands_sent
+        << " commands, received " << stats.states_received << " states" << std::endl;
+    return 0;
+  }
+
+  if (mode == "loadtest") {
+    auto server_config = net::ServerConfig{};
+    server_config.worker_threads = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+    auto server = net::Server{server_config};
+    auto server_thread = std::thread{[&server] { server.run(); }};
+
+    auto bot_config = net::BotConfig{};
+    bot_config.server_port = server.port();
+    bot_config.bots = Argument(argc, argv, 2, 64);
+    bot_config.commands_per_second = Argument(argc, argv, 4, 50);
+    auto const duration = seconds{Argument(argc, argv, 3, 5)};
+
+    auto const start = steady_clock::now();
+    auto swarm = net::BotSwarm{bot_config};
+    swarm.run_for(duration);
+    server.stop();
+    server_thread.join();
+
+    std::cout << bot_config.bots << " bots sent " << swarm.stats().commands_sent
+        << " commands and received " << swarm.stats().states_received << " states\n";
+    Print(server.stats(), steady_clock::now() - start);
+    return 0;
+  }
+#endif
 
-auto main(int, char const*[]) -> int {
-  std::cout << "Hello, World!" << std::endl;
-  return 0;
+  return Usage();
 }
@@ -0,0 +1,174 @@
+#include "agent.h"
+#include "game.h"
+#include "thread_pool.h"
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+using namespace agents;
+using game::Game;
+using game::UnitProperties;
+using geometry::Location;
+
+namespace {
+  void UpdateTimes(AgentRuntime& runtime, int times) {
+    for (int i = times; i > 0; --i) {
+      runtime.update();
+    }
+  }
+
+
+  auto Sleeper(int period, int& wake_ups) -> Agent {
+    for (;;) {
+      co_await ticks(period);
+      ++wake_ups;
+    }
+  }
+
+
+  auto Walker(AgentRuntime& runtime, Game::UnitRef unit, Location destination, bool& arrived) -> Agent {
+    runtime.move(unit, destination);
+    arrived = co_await command_finished(unit);
+  }
+
+
+  auto Guard(Game::UnitRef unit, std::vector<bool>& hits) -> Agent {
+    for (;;) {
+      auto const alive = co_await unit_damaged(unit);
+      hits.push_back(alive);
+      if (!alive) {
+        co_return;
+      }
+    }
+  }
+
+
+  auto Counter(int& resumes) -> Agent {
+    for (;;) {
+      ++resumes;
+      co_await ticks(1);
+    }
+  }
+
+
+  auto Failing() -> Agent {
+    co_await ticks(1);
+    throw std::runtime_error("failed");
+  }
+}
+
+
+TEST_CASE("Agents sleep for a number of game ticks") {
+  auto game = Game{};
+  auto workers = concurrency::ThreadPool{0};
+  auto runtime = AgentRuntime{game, workers, std::chrono::milliseconds{10}};
+
+  auto wake_ups = 0;
+  runtime.spawn(Sleeper(3, wake_ups));
+
+  UpdateTimes(runtime, 3);
+  REQUIRE(wake_ups == 0);
+  UpdateTimes(runtime, 1);
+  REQUIRE(wake_ups == 1);
+  UpdateTimes(runtime, 6);
+  REQUIRE(wake_ups == 3);
+}
+
+
+TEST_CASE("Agents wait for the commands they give to be finished") {
+  auto game = Game{};
+  auto workers = concurrency::ThreadPool{2};
+  auto runtime = AgentRuntime{game, workers, std::chrono::milliseconds{10}};
+  auto const unit = game.spawn_unit_at({0, 0}, {});
+
+  auto arrived = false;
+  runtime.spawn(Walker(runtime, unit, {5, 0}, arrived));
+
+  UpdateTimes(runtime, 5);
+  REQUIRE_FALSE(arrived);
+  REQUIRE(game.active_command_for(unit) == game::Command::Move);
+
+  UpdateTimes(runtime, 1);
+  REQUIRE(arrived);
+  REQUIRE(game.position_of(unit) == Location{5, 0});
+  REQUIRE(runtime.stats().agents == 0);
+}
+
+
+TEST_CASE("Agents are woken when their unit is damaged") {
+  auto game = Game{};
+  auto workers = concurrency::ThreadPool{0};
+  auto runtime = AgentRuntime{game, workers, std::chrono::milliseconds{10}};
+
+  UnitProperties const victim_props = UnitProperties::Make().hit_points(6);
+  auto const victim = game.spawn_unit_at({5, 5}, victim_props);
+  UnitProperties const attacker_props = UnitProperties::Make().attack_damage(2);
+  auto const attacker = game.spawn_unit_at({6, 5}, attacker_props);
+
+  auto hits = std::vector<bool>{};
+  runtime.spawn(Guard(victim, hits));
+  runtime.update();
+  REQUIRE(hits.empty());
+
+  runtime.attack(attacker, victim);
+  UpdateTimes(runtime, 5);
+
+  REQUIRE(hits == std::vector<bool>{true, true, false});
+  REQUIRE(runtime.stats().agents == 0);
+}
+
+
+TEST_CASE("Waiting agents are not resumed at all") {
+  auto game = Game{};
+  auto workers = concurrency::ThreadPool{0};
+  auto runtime = AgentRuntime{game, workers, std::chrono::milliseconds{10}};
+  auto const unit = game.spawn_unit_at({0, 0}, {});
+
+  auto hits = std::vector<bool>{};
+  for (auto i = 0; i < 1000; ++i) {
+    runtime.spawn(Guard(unit, hits));
+  }
+  UpdateTimes(runtime, 10);
+
+  REQUIRE(runtime.stats().agents == 1000);
+  REQUIRE(runtime.stats().resumed == 1000);
+}
+
+
+TEST_CASE("Agents over the CPU budget of a tick are deferred to the next one") {
+  auto game = Game{};
+  auto const thread_count = GENERATE(0, 3);
+  auto workers = concurrency::ThreadPool{static_cast<std::size_t>(thread_count)};
+  auto runtime = AgentRuntime{game, workers, std::chrono::nanoseconds{0}};
+
+  auto resumes = std::vector<int>(8);
+  for (auto& count : resumes) {
+    runtime.spawn(Counter(count));
+  }
+
+  runtime.update();
+  auto const slices = static_cast<std::uint64_t>(thread_count + 1);
+  REQUIRE(runtime.stats().resumed == slices);
+  REQUIRE(runtime.stats().deferred == 8 - slices);
+
+  UpdateTimes(runtime, 8);
+  for (auto const count : resumes) {
+    REQUIRE(count > 0);
+  }
+}
+
+
+TEST_CASE("The failure of an agent is passed on by the update") {
+  auto game = Game{};
+  auto workers = concurrency::ThreadPool{1};
+  auto runtime = AgentRuntime{game, workers, std::chrono::milliseconds{10}};
+
+  runtime.spawn(Failing());
+  runtime.update();
+  REQUIRE_THROWS_AS(runtime.update(), std::runtime_error);
+  REQUIRE(runtime.stats().agents == 0);
+}
@@ -0,0 +1,290 @@
+#include "agent.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace agents {
+  thread_local AgentRuntime::Slice* AgentRuntime::current_slice_ = nullptr;
+
+
+  auto AgentRuntime::current_slice() -> Slice& {
+    if (!current_slice_) {
+      throw std::logic_error("Agents may only wait while run by an AgentRuntime!");
+    }
+    return *current_slice_;
+  }
+
+
+  void TicksAwaiter::await_suspend(Agent::Handle agent) const {
+    AgentRuntime::current_slice().sleeping.push_back({agent, ticks});
+  }
+
+
+  void UnitEventAwaiter::await_suspend(Agent::Handle handle) {
+    agent = handle;
+    AgentRuntime::current_slice().waiting.push_back({handle, event, unit});
+  }
+
+
+  class AgentRuntime::Listener : public game::Game::GameEvents {
+    AgentRuntime& runtime_;
+
+  public:
+    explicit Listener(AgentRuntime& runtime) : runtime_{runtime} {}
+
+    void damage(UnitRef unit) override {
+      runtime_.wake(runtime_.damage_waiters_, unit, true);
+    }
+
+    void casualty(UnitRef unit) override {
+      runtime_.wake(runtime_.damage_waiters_, unit, false);
+      runtime_.wake(runtime_.command_waiters_, unit, false);
+    }
+
+    void command_finished(UnitRef unit) override {
+      runtime_.wake(runtime_.command_waiters_, unit, true);
+    }
+  };
+
+
+  void AgentRuntime::Slice::clear() {
+    orders.clear();
+    sleeping.clear();
+    waiting.clear();
+    spawned.clear();
+    deferred.clear();
+    resumed = 0;
+    finished = 0;
+    error = nullptr;
+  }
+
+
+  AgentRuntime::AgentRuntime(
+      game::Game& game, concurrency::ThreadPool& workers, Clock::duration budget_per_tick
+  )
+      : game_{game}
+      , workers_{workers}
+      , budget_{budget_per_tick}
+      , listener_{std::make_shared<Listener>(*this)}
+      , slices_(workers.thread_count() + 1)
+  {
+    game_.listen(listener_);
+  }
+
+
+  AgentRuntime::~AgentRuntime() {
+    game_.listen(nullptr);
+
+    for (auto agent : ready_) {
+      agent.destroy();
+    }
+    for (; !timers_.empty(); timers_.pop()) {
+      timers_.top().agent.destroy();
+    }
+    for (auto* waiters : {&command_waiters_, &damage_waiters_}) {
+      for (auto& [unit, agents] : *waiters) {
+        for (auto agent : agents) {
+          agent.destroy();
+        }
+      }
+    }
+  }
+
+
+  void AgentRuntime::spawn(Agent agent) {
+    auto const handle = std::exchange(agent.handle_, {});
+    if (current_slice_) {
+      current_slice_->spawned.push_back(handle);
+    }
+    else {
+      ready_.push_back(handle);
+      ++agents_;
+    }
+  }
+
+
+  void AgentRuntime::update() {
+    game_.update();
+    ++tick_;
+
+    for (; !timers_.empty() && timers_.top().tick <= tick_; timers_.pop()) {
+      ready_.push_back(timers_.top().agent);
+    }
+    run_ready();
+  }
+
+
+  void AgentRuntime::run_ready() {
+    if (ready_.empty()) {
+      return;
+    }
+
+    auto const deadline = Clock::now() + budget_;
+    auto const slice_count = std::min(ready_.size(), slices_.size());
+    auto const agent_count = ready_.size();
+    workers_.run(slice_count, [&](std::size_t index) {
+      run_slice(
+          slices_[index],
+          agent_count * index / slice_count,
+          agent_count * (index + 1) / slice_count,
+          deadline
+      );
+    });
+    merge(slice_count);
+  }
+
+
+  void AgentRuntime::run_slice(
+      Slice& slice, std::size_t begin, std::size_t end, Clock::time_point deadline
+  ) {
+    slice.clear();
+    current_slice_ = &slice;
+    for (auto index = begin; index < end; ++index) {
+      if (index > begin && Clock::now() >= deadline) {
+        slice.deferred.assign(ready_.begin() + index, ready_.begin() + end);
+        break;
+      }
+
+      auto const agent = ready_[index];
+      try {
+        agent.resume();
+      }
+      catch (...) {
+        if (!slice.error) {
+          slice.error = std::current_exception();
+        }
+      }
+      ++slice.resumed;
+
+      // A coroutine whose body threw counts as done as well.
+      if (agent.done()) {
+        agent.destroy();
+        ++slice.finished;
+      }
+    }
+    current_slice_ = nullptr;
+  }
+
+
+  void AgentRuntime::merge(std::size_t slice_count) {
+    ready_.clear();
+    auto error = std::exception_ptr{};
+
+    for (auto index = std::size_t{0}; index < slice_count; ++index) {
+      auto& slice = slices_[index];
+      for (auto const& order : slice.orders) {
+        give(order);
+      }
+      ready_.insert(ready_.end(), slice.deferred.begin(), slice.deferred.end());
+      stats_.resumed += slice.resumed;
+      stats_.deferred += slice.deferred.size();
+      stats_.finished += slice.finished;
+      agents_ -= slice.finished;
+      if (!error) {
+        error = slice.error;
+      }
+    }
+
+    // Waits are registered once every order is in, so an agent waiting for
+    // the command it has just given sees that command.
+    for (auto index = std::size_t{0}; index < slice_count; ++index) {
+      auto& slice = slices_[index];
+      for (auto const& [agent, count] : slice.sleeping) {
+        timers_.push({tick_ + count, timer_sequence_++, agent});
+      }
+      for (auto const& suspension : slice.waiting) {
+        wait(suspension);
+      }
+      ready_.insert(ready_.end(), slice.spawned.begin(), slice.spawned.end());
+      agents_ += slice.spawned.size();
+    }
+
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+
+  void AgentRuntime::wait(Suspension const& suspension) {
+    auto const& [agent, event, unit] = suspension;
+    if (!game_.contains(unit)) {
+      agent.promise().wake_result = false;
+      ready_.push_back(agent);
+      return;
+    }
+
+    if (event == UnitEvent::CommandFinished) {
+      if (game_.active_command_for(unit) == game::Command::None) {
+        agent.promise().wake_result = true;
+        ready_.push_back(agent);
+        return;
+      }
+      command_waiters_[unit.id].push_back(agent);
+    }
+    else {
+      damage_waiters_[unit.id].push_back(agent);
+    }
+  }
+
+
+  void AgentRuntime::wake(Waiters& waiters, UnitRef unit, bool result) {
+    auto const it = waiters.find(unit.id);
+    if (it == waiters.end()) {
+      return;
+    }
+
+    for (auto agent : it->second) {
+      agent.promise().wake_result = result;
+      ready_.push_back(agent);
+    }
+    waiters.erase(it);
+  }
+
+
+  void AgentRuntime::give(Order const& order) {
+    auto const& [kind, unit, location, target] = order;
+    auto const attacking = kind == OrderKind::Attack || kind == OrderKind::QueueAttack;
+    if (!game_.contains(unit) || (attacking && !game_.contains(target))) {
+      return;
+    }
+
+    switch (kind) {
+      case OrderKind::Move: game_.move(unit, location); break;
+      case OrderKind::Attack: game_.attack(unit, target); break;
+      case OrderKind::QueueMove: game_.queue_move(unit, location); break;
+      case OrderKind::QueueAttack: game_.queue_attack(unit, target); break;
+    }
+  }
+
+
+  void AgentRuntime::order(Order const& order) {
+    if (current_slice_) {
+      current_slice_->orders.push_back(order);
+    }
+    else {
+      give(order);
+    }
+  }
+
+
+  void AgentRuntime::move(UnitRef unit, geometry::Location location) {
+    order({OrderKind::Move, unit, location, {}});
+  }
+
+  void AgentRuntime::attack(UnitRef unit, UnitRef target) {
+    order({OrderKind::Attack, unit, {}, target});
+  }
+
+  void AgentRuntime::queue_move(UnitRef unit, geometry::Location location) {
+    order({OrderKind::QueueMove, unit, location, {}});
+  }
+
+  void AgentRuntime::queue_attack(UnitRef unit, UnitRef target) {
+    order({OrderKind::QueueAttack, unit, {}, target});
+  }
+
+
+  auto AgentRuntime::stats() const -> AgentStats {
+    return {agents_, stats_.resumed, stats_.deferred, stats_.finished};
+  }
+}
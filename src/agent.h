@@ -0,0 +1,220 @@
+#pragma once
+
+#include "game.h"
+#include "geometry.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace agents {
+  class AgentRuntime;
+
+  // Coroutine type of a scripted agent. An agent does nothing until it is
+  // handed to AgentRuntime::spawn(); from then on it runs between game ticks
+  // and spends the time in between suspended on one of the awaitables below.
+  class Agent {
+  public:
+    struct promise_type {
+      bool wake_result{true};
+
+      auto get_return_object() -> Agent {
+        return Agent{std::coroutine_handle<promise_type>::from_promise(*this)};
+      }
+      auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+      auto final_suspend() noexcept -> std::suspend_always { return {}; }
+      void return_void() noexcept {}
+      void unhandled_exception() { throw; }
+    };
+    using Handle = std::coroutine_handle<promise_type>;
+
+  private:
+    friend class AgentRuntime;
+    Handle handle_;
+    explicit Agent(Handle handle) : handle_{handle} {}
+
+  public:
+    Agent(Agent&& rhs) noexcept : handle_{std::exchange(rhs.handle_, {})} {}
+    auto operator=(Agent&&) -> Agent& = delete;
+    ~Agent() {
+      if (handle_) {
+        handle_.destroy();
+      }
+    }
+  };
+
+
+  struct TicksAwaiter {
+    int ticks;
+
+    auto await_ready() const noexcept -> bool { return ticks <= 0; }
+    void await_suspend(Agent::Handle) const;
+    void await_resume() const noexcept {}
+  };
+
+  enum class UnitEvent { CommandFinished, Damaged };
+
+  struct UnitEventAwaiter {
+    UnitEvent event;
+    game::Game::UnitRef unit;
+    Agent::Handle agent{};
+
+    auto await_ready() const noexcept -> bool { return false; }
+    void await_suspend(Agent::Handle);
+    auto await_resume() const noexcept -> bool { return agent.promise().wake_result; }
+  };
+
+  // Resume after the given number of game ticks.
+  inline auto ticks(int count) -> TicksAwaiter { return {count}; }
+
+  // Resume once the unit's current command is finished, or at the next
+  // tick if it has none. Yields false if the unit is gone instead.
+  inline auto command_finished(game::Game::UnitRef unit) -> UnitEventAwaiter {
+    return {UnitEvent::CommandFinished, unit};
+  }
+
+  // Resume when the unit takes damage. Yields false if it was killed.
+  inline auto unit_damaged(game::Game::UnitRef unit) -> UnitEventAwaiter {
+    return {UnitEvent::Damaged, unit};
+  }
+
+
+  struct AgentStats {
+    std::size_t agents;
+    std::uint64_t resumed;
+    std::uint64_t deferred;
+    std::uint64_t finished;
+  };
+
+
+  // Runs scripted agents against a game, waking each of them only when
+  // what it waits for has happened: sleeping agents cost nothing per tick.
+  //
+  // After every game update, the agents due are resumed on the worker pool,
+  // split into one slice per worker. Agents only read the game while they
+  // run; the orders they give through the runtime are applied afterwards,
+  // slice by slice, so the outcome does not depend on the thread timing.
+  // Resuming stops once the tick's CPU budget is spent, and the agents left
+  // over go first at the next tick. Each slice resumes at least one agent
+  // per tick, so every agent gets its turn eventually.
+  //
+  // The runtime listens to the game's events and takes its listener slot.
+  class AgentRuntime {
+  public:
+    using Clock = std::chrono::steady_clock;
+    using UnitRef = game::Game::UnitRef;
+
+  private:
+    enum class OrderKind { Move, Attack, QueueMove, QueueAttack };
+
+    struct Order {
+      OrderKind kind;
+      UnitRef unit;
+      geometry::Location location;
+      UnitRef target;
+    };
+
+    struct Sleep {
+      Agent::Handle agent;
+      int ticks;
+    };
+
+    struct Suspension {
+      Agent::Handle agent;
+      UnitEvent event;
+      UnitRef unit;
+    };
+
+    struct Timer {
+      long long tick;
+      std::uint64_t sequence;
+      Agent::Handle agent;
+
+      auto operator>(Timer const& rhs) const -> bool {
+        return std::pair{tick, sequence} > std::pair{rhs.tick, rhs.sequence};
+      }
+    };
+
+    // What the agents of one slice did while they ran.
+    struct Slice {
+      std::vector<Order> orders;
+      std::vector<Sleep> sleeping;
+      std::vector<Suspension> waiting;
+      std::vector<Agent::Handle> spawned;
+      std::vector<Agent::Handle> deferred;
+      std::uint64_t resumed{0};
+      std::uint64_t finished{0};
+      std::exception_ptr error;
+
+      void clear();
+    };
+
+    class Listener;
+    friend struct TicksAwaiter;
+    friend struct UnitEventAwaiter;
+    friend class Listener;
+
+    using Waiters = std::unordered_map<int, std::vector<Agent::Handle>>;
+
+    // The slice being run on this thread, if any.
+    static thread_local Slice* current_slice_;
+    static auto current_slice() -> Slice&;
+
+    game::Game& game_;
+    concurrency::ThreadPool& workers_;
+    Clock::duration const budget_;
+    std::shared_ptr<Listener> listener_;
+
+    long long tick_{0};
+    std::vector<Agent::Handle> ready_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<>> timers_;
+    std::uint64_t timer_sequence_{0};
+    Waiters command_waiters_;
+    Waiters damage_waiters_;
+    std::vector<Slice> slices_;
+    std::size_t agents_{0};
+    AgentStats stats_{};
+
+    void run_ready();
+    void run_slice(Slice&, std::size_t begin, std::size_t end, Clock::time_point deadline);
+    void merge(std::size_t slice_count);
+    void give(Order const&);
+    void order(Order const&);
+    void wait(Suspension const&);
+    void wake(Waiters&, UnitRef, bool result);
+
+  public:
+    AgentRuntime(game::Game&, concurrency::ThreadPool&, Clock::duration budget_per_tick);
+    ~AgentRuntime();
+
+    AgentRuntime(AgentRuntime const&) = delete;
+    auto operator=(AgentRuntime const&) -> AgentRuntime& = delete;
+
+    auto game() const -> game::Game const& { return game_; }
+
+    // Start an agent at the next update(). May be called from agents.
+    void spawn(Agent);
+
+    // Update the game, then resume the agents due.
+    void update();
+
+    // Orders given by running agents are applied once all of them have
+    // run; orders for units which are gone by then are dropped. Outside of
+    // agents the orders go to the game right away.
+    void move(UnitRef, geometry::Location);
+    void attack(UnitRef, UnitRef target);
+    void queue_move(UnitRef, geometry::Location);
+    void queue_attack(UnitRef, UnitRef target);
+
+    auto stats() const -> AgentStats;
+  };
+}
@@ -0,0 +1,203 @@
+#include "bot_client.h"
+
+#include "protocol.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+#include <system_error>
+
+using namespace std::chrono;
+
+namespace net {
+  namespace {
+    constexpr auto BotTickRate = 20;
+
+    auto SystemError(char const* what) -> std::system_error {
+      return std::system_error{errno, std::generic_category(), what};
+    }
+  }
+
+
+  BotSwarm::BotSwarm(BotConfig config)
+      : config_{config}
+      , bots_(static_cast<std::size_t>(std::max(config.bots, 0)))
+  {
+    if (config_.games <= 0) {
+      throw std::invalid_argument("Bots need at least one game to join!");
+    }
+
+    epoll_ = ::epoll_create1(EPOLL_CLOEXEC);
+    timer_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (epoll_ < 0 || timer_ < 0) {
+      auto const error = SystemError("epoll/timerfd");
+      close_descriptors();
+      throw error;
+    }
+
+    auto server = sockaddr_in{};
+    server.sin_family = AF_INET;
+    server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    server.sin_port = htons(config_.server_port);
+
+    for (auto i = std::size_t{0}; i < bots_.size(); ++i) {
+      auto& bot = bots_[i];
+      bot.game = static_cast<std::uint32_t>(i % config_.games);
+      bot.socket = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      if (bot.socket < 0
+          || ::connect(bot.socket, reinterpret_cast<sockaddr*>(&server), sizeof(server)) != 0) {
+        auto const error = SystemError("bot socket");
+        close_descriptors();
+        throw error;
+      }
+
+      auto event = epoll_event{};
+      event.events = EPOLLIN;
+      event.data.u64 = i;
+      ::epoll_ctl(epoll_, EPOLL_CTL_ADD, bot.socket, &event);
+    }
+
+    auto event = epoll_event{};
+    event.events = EPOLLIN;
+    event.data.u64 = bots_.size();
+    ::epoll_ctl(epoll_, EPOLL_CTL_ADD, timer_, &event);
+  }
+
+
+  BotSwarm::~BotSwarm() {
+    close_descriptors();
+  }
+
+
+  void BotSwarm::close_descriptors() {
+    for (auto& bot : bots_) {
+      if (bot.socket >= 0) {
+        ::close(bot.socket);
+        bot.socket = -1;
+      }
+    }
+    for (auto* fd : {&epoll_, &timer_}) {
+      if (*fd >= 0) {
+        ::close(*fd);
+        *fd = -1;
+      }
+    }
+  }
+
+
+  void BotSwarm::run_for(steady_clock::duration duration) {
+    auto const period = duration_cast<nanoseconds>(seconds{1}) / BotTickRate;
+    auto spec = itimerspec{};
+    spec.it_value.tv_nsec = spec.it_interval.tv_nsec = period.count();
+    ::timerfd_settime(timer_, 0, &spec, nullptr);
+
+    auto const deadline = steady_clock::now() + duration;
+    auto events = std::array<epoll_event, 64>{};
+    for (auto now = steady_clock::now(); now < deadline; now = steady_clock::now()) {
+      auto const timeout = duration_cast<milliseconds>(deadline - now).count() + 1;
+      auto const count = ::epoll_wait(
+          epoll_, events.data(), events.size(), static_cast<int>(timeout)
+      );
+      if (count < 0 && errno != EINTR) {
+        throw SystemError("epoll_wait");
+      }
+
+      for (auto i = 0; i < count; ++i) {
+        auto const index = events[i].data.u64;
+        if (index < bots_.size()) {
+          receive(bots_[index]);
+          continue;
+        }
+
+        auto expirations = std::uint64_t{0};
+        if (::read(timer_, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+          continue;
+        }
+        auto const elapsed = static_cast<double>(expirations) / BotTickRate;
+        for (auto& bot : bots_) {
+          send_commands(bot, elapsed);
+        }
+      }
+    }
+
+    auto const disarm = itimerspec{};
+    ::timerfd_settime(timer_, 0, &disarm, nullptr);
+  }
+
+
+  void BotSwarm::receive(Bot& bot) {
+    auto buffer = std::array<std::uint8_t, MaxDatagramSize>{};
+    for (;;) {
+      auto const size = ::recv(bot.socket, buffer.data(), buffer.size(), MSG_DONTWAIT);
+      if (size <= 0) {
+        return;
+      }
+
+      auto const type = TypeOf(buffer.data(), size);
+      if (type == MessageType::Welcome) {
+        auto welcome = Welcome{};
+        if (Decode(buffer.data(), size, welcome) && bot.player < 0) {
+          bot.player = welcome.player;
+          ++stats_.joined;
+        }
+      }
+      else if (type == MessageType::State) {
+        auto state = State{};
+        if (!Decode(buffer.data(), size, state)) {
+          continue;
+        }
+        ++stats_.states_received;
+        for (auto i = 0; i < state.count; ++i) {
+          auto const& unit = state.units[i];
+          auto const known = std::find(bot.units.begin(), bot.units.end(), unit.id);
+          if (unit.owner == bot.player && known == bot.units.end()) {
+            bot.units.push_back(unit.id);
+          }
+        }
+      }
+    }
+  }
+
+
+  void BotSwarm::send_commands(Bot& bot, double elapsed_seconds) {
+    auto buffer = std::array<std::uint8_t, MaxDatagramSize>{};
+    if (bot.player < 0) {
+      // Joins may get lost like any other datagram; keep asking.
+      auto const size = Encode(Join{bot.game}, buffer.data(), buffer.size());
+      ::send(bot.socket, buffer.data(), size, MSG_DONTWAIT);
+      return;
+    }
+    if (bot.units.empty()) {
+      return;
+    }
+
+    bot.credit += config_.commands_per_second * elapsed_seconds;
+    auto position = std::uniform_real_distribution<float>{0.0f, config_.map_size};
+    auto pick = std::uniform_int_distribution<std::size_t>{0, bot.units.size() - 1};
+
+    while (bot.credit >= 1.0) {
+      auto batch = CommandBatch{};
+      batch.game = bot.game;
+      while (bot.credit >= 1.0 && batch.count < CommandBatch::Capacity) {
+        batch.commands[batch.count++] = {
+          CommandKind::Move, bot.units[pick(random_)], position(random_), position(random_), 0
+        };
+        bot.credit -= 1.0;
+      }
+
+      auto const size = Encode(batch, buffer.data(), buffer.size());
+      if (::send(bot.socket, buffer.data(), size, MSG_DONTWAIT) > 0) {
+        stats_.commands_sent += batch.count;
+      }
+    }
+  }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "protocol.h"
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace net {
+  struct BotConfig {
+    std::uint16_t server_port{0};
+    int bots{8};
+    int games{1};
+    int commands_per_second{20};
+    float map_size{1000.0f};
+  };
+
+
+  struct BotStats {
+    std::uint64_t joined;
+    std::uint64_t commands_sent;
+    std::uint64_t states_received;
+  };
+
+
+  // A swarm of scripted clients for load testing a server on the loopback
+  // interface. Each bot has its own socket, joins a game, learns its units
+  // from the state broadcasts and keeps sending batches of random moves to
+  // them. All bots are driven by a single epoll loop.
+  class BotSwarm {
+    struct Bot {
+      int socket{-1};
+      std::uint32_t game{0};
+      int player{-1};
+      std::vector<std::int32_t> units;
+      double credit{0.0};
+    };
+
+    BotConfig const config_;
+    std::vector<Bot> bots_;
+    int epoll_{-1};
+    int timer_{-1};
+    std::minstd_rand random_;
+    BotStats stats_{};
+
+    void close_descriptors();
+    void receive(Bot&);
+    void send_commands(Bot&, double elapsed_seconds);
+
+  public:
+    explicit BotSwarm(BotConfig);
+    ~BotSwarm();
+
+    BotSwarm(BotSwarm const&) = delete;
+    auto operator=(BotSwarm const&) -> BotSwarm& = delete;
+
+    void run_for(std::chrono::steady_clock::duration);
+
+    auto stats() const -> BotStats { return stats_; }
+  };
+}
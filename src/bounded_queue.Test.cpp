@@ -0,0 +1,69 @@
+#include "bounded_queue.h"
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using container::BoundedQueue;
+
+
+TEST_CASE("A bounded queue holds a fixed number of elements in order") {
+  auto queue = BoundedQueue<int>{4};
+  REQUIRE(queue.capacity() == 4);
+
+  for (auto i = 0; i < 4; ++i) {
+    REQUIRE(queue.try_push(int{i}));
+  }
+  REQUIRE_FALSE(queue.try_push(4));
+  REQUIRE(queue.size() == 4);
+
+  auto value = -1;
+  for (auto i = 0; i < 4; ++i) {
+    REQUIRE(queue.try_pop(value));
+    REQUIRE(value == i);
+  }
+  REQUIRE_FALSE(queue.try_pop(value));
+}
+
+
+TEST_CASE("A bounded queue needs a power of two capacity") {
+  REQUIRE_THROWS_AS(BoundedQueue<int>{6}, std::invalid_argument);
+}
+
+
+TEST_CASE("A bounded queue takes elements from many producers") {
+  auto queue = BoundedQueue<int>{64};
+  constexpr auto Producers = 4;
+  constexpr auto PerProducer = 10000;
+
+  auto producers = std::vector<std::thread>{};
+  for (auto p = 0; p < Producers; ++p) {
+    producers.emplace_back([&queue, p] {
+      for (auto i = 0; i < PerProducer; ++i) {
+        while (!queue.try_push(p * PerProducer + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  auto last = std::vector<int>(Producers, -1);
+  auto in_order = true;
+  for (auto received = 0; received < Producers * PerProducer;) {
+    auto value = 0;
+    if (queue.try_pop(value)) {
+      auto const producer = value / PerProducer;
+      in_order = in_order && value > last[producer];
+      last[producer] = value;
+      ++received;
+    }
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+
+  REQUIRE(in_order);
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace container {
+  // Fixed-capacity lock-free queue for any number of producers and
+  // consumers. Every cell carries a sequence number telling whose turn it is,
+  // so pushing and popping only contend on their own end of the queue.
+  template<typename T>
+  class BoundedQueue {
+    struct Cell {
+      std::atomic<std::size_t> sequence;
+      T value;
+    };
+
+    static auto MaskFor(std::size_t capacity) -> std::size_t {
+      if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+        throw std::invalid_argument("Queue capacity must be a power of two!");
+      }
+      return capacity - 1;
+    }
+
+    std::size_t const mask_;
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<std::size_t> tail_{0};
+    alignas(64) std::atomic<std::size_t> head_{0};
+
+  public:
+    // The capacity has to be a power of two.
+    explicit BoundedQueue(std::size_t capacity)
+        : mask_{MaskFor(capacity)}
+        , cells_{new Cell[capacity]}
+    {
+      for (auto i = std::size_t{0}; i < capacity; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+      }
+    }
+
+    auto capacity() const noexcept -> std::size_t { return mask_ + 1; }
+
+    // Approximate while other threads are using the queue.
+    auto size() const noexcept -> std::size_t {
+      return tail_.load(std::memory_order_relaxed)
+          - head_.load(std::memory_order_relaxed);
+    }
+
+    auto try_push(T&& value) -> bool {
+      auto position = tail_.load(std::memory_order_relaxed);
+      for (;;) {
+        auto& cell = cells_[position & mask_];
+        auto const sequence = cell.sequence.load(std::memory_order_acquire);
+        auto const lag = static_cast<std::ptrdiff_t>(sequence - position);
+        if (lag == 0) {
+          if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+            cell.value = std::move(value);
+            cell.sequence.store(position + 1, std::memory_order_release);
+            return true;
+          }
+        }
+        else if (lag < 0) {
+          return false;
+        }
+        else {
+          position = tail_.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    auto try_pop(T& value) -> bool {
+      auto position = head_.load(std::memory_order_relaxed);
+      for (;;) {
+        auto& cell = cells_[position & mask_];
+        auto const sequence = cell.sequence.load(std::memory_order_acquire);
+        auto const lag = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+        if (lag == 0) {
+          if (head_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+            value = std::move(cell.value);
+            cell.sequence.store(position + mask_ + 1, std::memory_order_release);
+            return true;
+          }
+        }
+        else if (lag < 0) {
+          return false;
+        }
+        else {
+          position = head_.load(std::memory_order_relaxed);
+        }
+      }
+    }
+  };
+}
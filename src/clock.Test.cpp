@@ -0,0 +1,73 @@
+#include "clock.h"
+
+#include "game.h"
+#include "geometry.h"
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <stdexcept>
+
+using namespace game;
+using namespace std::chrono_literals;
+using geometry::Location;
+
+
+TEST_CASE("A fixed rate clock runs the game at its own tick rate") {
+  auto game = Game{};
+  auto const unit = game.spawn_unit_at({0, 0}, {});
+  game.move(unit, {100, 0});
+
+  auto clock = FixedRateClock{game, 10};
+  REQUIRE(clock.tick_period() == 100ms);
+
+  SECTION("and does not tick until a full tick period has passed") {
+    REQUIRE(clock.advance(60ms) == 0);
+    REQUIRE(game.position_of(unit) == Location{0, 0});
+
+    REQUIRE(clock.advance(60ms) == 1);
+    REQUIRE(game.position_of(unit) == Location{1, 0});
+  }
+
+  SECTION("and catches up with several ticks when the caller falls behind") {
+    REQUIRE(clock.advance(300ms) == 3);
+    REQUIRE(clock.ticks() == 3);
+    REQUIRE(game.position_of(unit) == Location{3, 0});
+  }
+
+  SECTION("but never runs more ticks in a batch than its limit") {
+    REQUIRE(clock.advance(2s) == 5);
+    REQUIRE(clock.dropped_ticks() == 15);
+    REQUIRE(clock.advance(0ms) == 0);
+  }
+}
+
+
+TEST_CASE("A fixed rate clock needs a positive tick rate and batch size") {
+  auto game = Game{};
+  REQUIRE_THROWS_AS(FixedRateClock(game, 0), std::invalid_argument);
+  REQUIRE_THROWS_AS(FixedRateClock(game, 10, 0), std::invalid_argument);
+}
+
+
+TEST_CASE("A fixed rate clock interpolates positions between the last two ticks,"
+          " trailing the simulation by one tick") {
+  auto game = Game{};
+  UnitProperties const props = UnitProperties::Make().velocity(2);
+  auto const unit = game.spawn_unit_at({0, 0}, props);
+  game.move(unit, {100, 0});
+
+  auto clock = FixedRateClock{game, 10};
+  clock.advance(300ms);
+  REQUIRE(clock.alpha() == Approx(0.0f));
+  REQUIRE(clock.interpolated_position_of(unit).x == Approx(4.0f));
+
+  clock.advance(25ms);
+  REQUIRE(clock.alpha() == Approx(0.25f));
+  REQUIRE(clock.interpolated_position_of(unit).x == Approx(4.5f));
+
+  SECTION("except for units spawned since the last tick") {
+    auto const newcomer = game.spawn_unit_at({50, 50}, props);
+    REQUIRE(clock.interpolated_position_of(newcomer) == Location{50, 50});
+  }
+}
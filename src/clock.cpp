@@ -0,0 +1,85 @@
+#include "clock.h"
+
+#include "geometry.h"
+
+#include <chrono>
+#include <stdexcept>
+
+using namespace std::chrono;
+
+namespace game {
+  auto FixedRateClock::PeriodFor(
+      int ticks_per_second, int max_ticks_per_batch
+  ) -> Duration {
+    if (ticks_per_second <= 0 || max_ticks_per_batch <= 0) {
+      throw std::invalid_argument("Tick rate and batch size must be positive!");
+    }
+    return duration_cast<Duration>(seconds{1}) / ticks_per_second;
+  }
+
+
+  FixedRateClock::FixedRateClock(
+      Game& game, int ticks_per_second, int max_ticks_per_batch
+  )
+      : game_{game}
+      , tick_period_{PeriodFor(ticks_per_second, max_ticks_per_batch)}
+      , max_ticks_per_batch_{max_ticks_per_batch}
+  {
+    game_.snapshot_positions(current_);
+    previous_ = current_;
+  }
+
+
+  auto FixedRateClock::advance(Duration elapsed) -> int {
+    accumulated_ += elapsed;
+
+    auto due = accumulated_ / tick_period_;
+    accumulated_ -= due * tick_period_;
+    if (due > max_ticks_per_batch_) {
+      dropped_ticks_ += due - max_ticks_per_batch_;
+      due = max_ticks_per_batch_;
+    }
+
+    auto const batch = static_cast<int>(due);
+    for (auto i = 0; i < batch; ++i) {
+      // Only the last two ticks of the batch are ever interpolated between.
+      if (i == batch - 1) {
+        if (batch == 1) {
+          previous_.swap(current_);
+        }
+        else {
+          game_.snapshot_positions(previous_);
+        }
+      }
+      game_.update();
+    }
+
+    if (batch > 0) {
+      game_.snapshot_positions(current_);
+      ticks_ += batch;
+    }
+    return batch;
+  }
+
+
+  auto FixedRateClock::alpha() const -> float {
+    return duration<float>{accumulated_} / duration<float>{tick_period_};
+  }
+
+
+  auto FixedRateClock::interpolated_position_of(
+      Game::UnitRef ref
+  ) const -> geometry::Location {
+    auto const* current = current_.find(ref);
+    if (!current) {
+      return game_.position_of(ref);
+    }
+
+    auto const* previous = previous_.find(ref);
+    if (!previous) {
+      return *current;
+    }
+
+    return geometry::Interpolated(*previous, *current, alpha());
+  }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "game.h"
+#include "geometry.h"
+
+#include <chrono>
+
+namespace game {
+  // Drives a Game at a fixed tick rate, independent of how often the caller
+  // gets around to advancing it. Elapsed wall-clock time is accumulated and
+  // turned into whole ticks; if the caller falls behind, up to
+  // max_ticks_per_batch ticks are run back to back and the rest is dropped,
+  // so an overloaded host slows the simulation down instead of spiralling.
+  //
+  // Between two ticks, unit positions can be read interpolated for
+  // presentation purposes. The positions of the last two ticks are kept in
+  // flat snapshots whose storage is reused from batch to batch.
+  class FixedRateClock {
+  public:
+    using Duration = std::chrono::steady_clock::duration;
+
+  private:
+    static auto PeriodFor(int ticks_per_second, int max_ticks_per_batch) -> Duration;
+
+    Game& game_;
+    Duration const tick_period_;
+    int const max_ticks_per_batch_;
+
+    Duration accumulated_{Duration::zero()};
+    long long ticks_{0};
+    long long dropped_ticks_{0};
+
+    Game::PositionSnapshot previous_;
+    Game::PositionSnapshot current_;
+
+  public:
+    FixedRateClock(Game&, int ticks_per_second, int max_ticks_per_batch = 5);
+
+    // Account for the time passed since the previous call and run the ticks
+    // that are due. Returns the number of ticks run.
+    auto advance(Duration elapsed) -> int;
+
+    auto tick_period() const -> Duration { return tick_period_; }
+    auto ticks() const -> long long { return ticks_; }
+    auto dropped_ticks() const -> long long { return dropped_ticks_; }
+
+    // How far the time is between the last tick and the next one, in [0, 1).
+    auto alpha() const -> float;
+
+    // Units are only interpolated if they were there at both of the last
+    // two ticks. Otherwise, units spawned since the last tick are at their
+    // current location, and units spawned just before it at their location
+    // as of that tick. Throws like Game::position_of() for units not in the
+    // game.
+    auto interpolated_position_of(Game::UnitRef) const -> geometry::Location;
+  };
+}
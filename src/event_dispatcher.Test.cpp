@@ -0,0 +1,86 @@
+#include "event_dispatcher.h"
+
+#include "match.h"
+
+#include <catch2/catch.hpp>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace match;
+
+
+namespace {
+  struct RecordingListener : public Events {
+    std::vector<std::string> winners;
+    void finished(std::string const& winner) override { winners.push_back(winner); }
+  };
+}
+
+
+TEST_CASE("An event dispatcher delivers match events on its own thread") {
+  auto dispatcher = std::make_shared<EventDispatcher>();
+  auto const listener = std::make_shared<RecordingListener>();
+  dispatcher->listen(listener);
+
+  auto match = Match{"X", "Y"};
+  match.listen(dispatcher);
+  match.resign("X");
+
+  dispatcher->flush();
+  REQUIRE(listener->winners == std::vector<std::string>{"Y"});
+  REQUIRE(dispatcher->metrics().delivered == 1);
+}
+
+
+TEST_CASE("An event dispatcher keeps the order of events for every listener") {
+  auto dispatcher = EventDispatcher{8, 3};
+  auto const first = std::make_shared<RecordingListener>();
+  auto const second = std::make_shared<RecordingListener>();
+  dispatcher.listen(first);
+  dispatcher.listen(second);
+
+  auto expected = std::vector<std::string>{};
+  for (auto i = 0; i < 100; ++i) {
+    expected.push_back(std::to_string(i));
+    dispatcher.finished(expected.back());
+  }
+
+  dispatcher.flush();
+  REQUIRE(first->winners == expected);
+  REQUIRE(second->winners == expected);
+
+  auto const metrics = dispatcher.metrics();
+  REQUIRE(metrics.delivered == 100);
+  REQUIRE(metrics.capacity == 8);
+  REQUIRE(metrics.high_water_mark <= 8);
+  REQUIRE(metrics.depth == 0);
+}
+
+
+TEST_CASE("An event dispatcher calls a listener registered repeatedly once") {
+  auto dispatcher = EventDispatcher{};
+  auto const listener = std::make_shared<RecordingListener>();
+  for (auto i = 0; i < 3; ++i) {
+    dispatcher.listen(listener);
+  }
+
+  dispatcher.finished("X");
+  dispatcher.flush();
+  REQUIRE(listener->winners.size() == 1);
+}
+
+
+TEST_CASE("An event dispatcher does not keep its listeners alive") {
+  auto dispatcher = EventDispatcher{};
+  auto listener = std::make_shared<RecordingListener>();
+  auto const observer = std::weak_ptr<RecordingListener>{listener};
+  dispatcher.listen(listener);
+
+  listener.reset();
+  REQUIRE(observer.expired());
+  REQUIRE_NOTHROW(dispatcher.finished("X"));
+  dispatcher.flush();
+}
@@ -0,0 +1,153 @@
+#include "event_dispatcher.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace match {
+  EventDispatcher::EventDispatcher(std::size_t capacity, std::size_t batch_size)
+      : queue_{capacity}
+      , batch_size_{std::max(batch_size, std::size_t{1})}
+      , thread_{[this] { run(); }} {}
+
+
+  EventDispatcher::~EventDispatcher() {
+    stopping_ = true;
+    {
+      auto lock = std::lock_guard{wake_mutex_};
+    }
+    wake_.notify_one();
+    thread_.join();
+  }
+
+
+  void EventDispatcher::listen(EventsPtr listener) {
+    auto lock = std::lock_guard{listeners_mutex_};
+    auto const registered = std::any_of(
+        listeners_.begin(), listeners_.end(),
+        [&listener](std::weak_ptr<Events> const& existing) {
+          return existing.lock() == listener;
+        }
+    );
+    if (!registered) {
+      listeners_.push_back(listener);
+    }
+  }
+
+
+  void EventDispatcher::finished(std::string const& winner) {
+    post(winner);
+  }
+
+
+  void EventDispatcher::post(std::string winner) {
+    ++posted_;
+    if (!queue_.try_push(std::move(winner))) {
+      ++stalls_;
+      do {
+        std::this_thread::yield();
+      } while (!queue_.try_push(std::move(winner)));
+    }
+
+    auto const depth = queue_.size();
+    auto high_water_mark = high_water_mark_.load();
+    while (depth > high_water_mark
+        && !high_water_mark_.compare_exchange_weak(high_water_mark, depth)) {}
+
+    // Pairs with the fence in run(): either this sees the dispatcher going
+    // to sleep, or the dispatcher sees the event in the queue.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_) {
+      {
+        auto lock = std::lock_guard{wake_mutex_};
+      }
+      wake_.notify_one();
+    }
+  }
+
+
+  void EventDispatcher::deliver(std::vector<std::string> const& batch) {
+    auto listeners = std::vector<EventsPtr>{};
+    {
+      auto lock = std::lock_guard{listeners_mutex_};
+      listeners_.erase(
+          std::remove_if(listeners_.begin(), listeners_.end(),
+              [](std::weak_ptr<Events> const& l) { return l.expired(); }
+          ),
+          listeners_.end()
+      );
+      for (auto const& listener : listeners_) {
+        if (auto alive = listener.lock()) {
+          listeners.push_back(std::move(alive));
+        }
+      }
+    }
+
+    for (auto const& listener : listeners) {
+      for (auto const& winner : batch) {
+        listener->finished(winner);
+      }
+    }
+  }
+
+
+  void EventDispatcher::run() {
+    auto batch = std::vector<std::string>{};
+    batch.reserve(batch_size_);
+    for (;;) {
+      auto winner = std::string{};
+      while (batch.size() < batch_size_ && queue_.try_pop(winner)) {
+        batch.push_back(std::move(winner));
+      }
+
+      if (!batch.empty()) {
+        deliver(batch);
+        ++batches_;
+        delivered_ += batch.size();
+        batch.clear();
+        {
+          auto lock = std::lock_guard{wake_mutex_};
+        }
+        drained_.notify_all();
+        continue;
+      }
+
+      if (stopping_) {
+        return;
+      }
+
+      // Producers only notify a sleeping dispatcher. The fences make sure
+      // an event posted while going to sleep is either seen in the queue
+      // here or followed by a notification.
+      auto lock = std::unique_lock{wake_mutex_};
+      sleeping_ = true;
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      wake_.wait(lock, [this] { return queue_.size() > 0 || stopping_; });
+      sleeping_ = false;
+    }
+  }
+
+
+  void EventDispatcher::flush() {
+    auto const target = posted_.load();
+    auto lock = std::unique_lock{wake_mutex_};
+    drained_.wait(lock, [this, target] { return delivered_.load() >= target; });
+  }
+
+
+  auto EventDispatcher::metrics() const -> Metrics {
+    return {
+      queue_.size(),
+      queue_.capacity(),
+      high_water_mark_.load(),
+      delivered_.load(),
+      batches_.load(),
+      stalls_.load(),
+    };
+  }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "bounded_queue.h"
+#include "match.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+namespace match {
+  // Events listener that hands the notifications over to a dedicated thread
+  // and returns immediately, so slow listeners do not hold up the match.
+  //
+  // Register it with Match::listen() or MatchRegistry::listen() and the
+  // actual listeners with its own listen(). Those are held weakly and called
+  // in batches, each in the order the events happened. A listener
+  // registered more than once is called once, and listeners that have been
+  // destroyed are dropped.
+  //
+  // The queue is bounded: when it is full, the notifying thread waits for
+  // room, which shows up in the metrics as stalls.
+  class EventDispatcher : public Events {
+  public:
+    struct Metrics {
+      std::size_t depth;
+      std::size_t capacity;
+      std::size_t high_water_mark;
+      std::size_t delivered;
+      std::size_t batches;
+      std::size_t stalls;
+    };
+
+  private:
+    container::BoundedQueue<std::string> queue_;
+    std::size_t const batch_size_;
+
+    std::mutex listeners_mutex_;
+    std::vector<std::weak_ptr<Events>> listeners_;
+
+    std::atomic<std::size_t> posted_{0};
+    std::atomic<std::size_t> delivered_{0};
+    std::atomic<std::size_t> batches_{0};
+    std::atomic<std::size_t> stalls_{0};
+    std::atomic<std::size_t> high_water_mark_{0};
+
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::condition_variable drained_;
+    std::atomic<bool> sleeping_{false};
+    std::atomic<bool> stopping_{false};
+
+    std::thread thread_;
+
+    void post(std::string winner);
+    void run();
+    void deliver(std::vector<std::string> const& batch);
+
+  public:
+    explicit EventDispatcher(std::size_t capacity = 1024, std::size_t batch_size = 64);
+    ~EventDispatcher();
+
+    EventDispatcher(EventDispatcher const&) = delete;
+    auto operator=(EventDispatcher const&) -> EventDispatcher& = delete;
+
+    void listen(EventsPtr listener);
+
+    // Block until everything notified so far has been delivered.
+    void flush();
+
+    auto metrics() const -> Metrics;
+
+    void finished(std::string const& winner) override;
+  };
+}
@@ -6,7 +6,9 @@
 #include <trompeloeil.hpp>
 
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <sstream>
 
 
 namespace game {
@@ -91,6 +93,17 @@ TEST_CASE("Units are limited to the map's dimensions") {
     REQUIRE_THROWS_AS(game.spawn_unit_at({200, 200}, {}), InvalidPosition);
   }
 
+  SECTION("nor at a position which is not a number") {
+    auto const nan = std::numeric_limits<float>::quiet_NaN();
+    REQUIRE_THROWS_AS(game.spawn_unit_at({nan, 10}, {}), InvalidPosition);
+    REQUIRE_THROWS_AS(game.spawn_unit_at({10, nan}, {}), InvalidPosition);
+
+    auto const kinds = std::vector<UnitProperties>{UnitProperties{}};
+    auto const requests = std::vector<SpawnRequest>{{{nan, 10}, 0}};
+    auto refs = std::vector<Game::UnitRef>(1);
+    REQUIRE_THROWS_AS(game.spawn_units(kinds, requests, refs), InvalidPosition);
+  }
+
   SECTION("Units will stop at map boundaries") {
     auto unit = game.spawn_unit_at({0, 0}, {});
     game.move(unit, {200, 0});
@@ -190,6 +203,14 @@ TEST_CASE("A unit under attack looses HP (hit points)") {
 
     UpdateTimes(game, 5);
   }
+
+  SECTION("and is removed from the game even if nobody listens") {
+    UpdateTimes(game, 5);
+    REQUIRE_FALSE(game.contains(victim));
+    auto const states = game.unit_states();
+    REQUIRE(states->size() == 1);
+    REQUIRE(states->front().ref.id == attacker.id);
+  }
 }
 
 
@@ -255,6 +276,26 @@ TEST_CASE("Units can have a shape") {
     UpdateTimes(game, 20);
     REQUIRE_THAT(game.position_of(circular_unit), CloseTo({12, 10}));
   }
+
+  SECTION("of an axis aligned box, restricting movement by its extents") {
+    auto const box_unit = game.spawn_unit_at({100, 64},
+        UnitProperties::Make()
+            .shape(UnitShape::AABB{20.0f, 5.0f})
+    );
+    game.move(box_unit, {0, 0});
+    UpdateTimes(game, 150);
+    REQUIRE_THAT(game.position_of(box_unit), CloseTo({20, 5}));
+  }
+
+  SECTION("of a capsule, lying along the horizontal axis") {
+    auto const capsule_unit = game.spawn_unit_at({100, 64},
+        UnitProperties::Make()
+            .shape(UnitShape::Capsule{4.0f, 10.0f})
+    );
+    game.move(capsule_unit, {256, 128});
+    UpdateTimes(game, 200);
+    REQUIRE_THAT(game.position_of(capsule_unit), CloseTo({242, 124}));
+  }
 }
 
 
@@ -280,4 +321,312 @@ TEST_CASE("Units have acceleration") {
     UpdateTimes(game, 10);
     REQUIRE_THAT(game.position_of(unit), CloseTo({5.5f, 0}));
   }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Units can have a queue of commands") {
+  auto game = Game{};
+  auto const unit = game.spawn_unit_at({0, 0}, {});
+
+  SECTION("which are carried out one after the other") {
+    game.move(unit, {10, 0});
+    game.queue_move(unit, {10, 10});
+    game.queue_move(unit, {0, 10});
+
+    UpdateTimes(game, 10);
+    REQUIRE_THAT(game.position_of(unit), CloseTo({10, 0}));
+    REQUIRE(game.active_command_for(unit) == Command::Move);
+
+    UpdateTimes(game, 20);
+    REQUIRE_THAT(game.position_of(unit), CloseTo({0, 10}));
+    REQUIRE(game.active_command_for(unit) == Command::None);
+  }
+
+  SECTION("longer than what fits into the unit itself") {
+    constexpr auto Waypoints = 12;
+    for (auto i = 1; i <= Waypoints; ++i) {
+      game.queue_move(unit, {static_cast<float>(i), 0});
+    }
+
+    UpdateTimes(game, Waypoints);
+    REQUIRE_THAT(game.position_of(unit), CloseTo({Waypoints, 0}));
+    REQUIRE(game.active_command_for(unit) == Command::None);
+  }
+
+  SECTION("which a new direct command replaces") {
+    game.move(unit, {10, 0});
+    game.queue_move(unit, {10, 10});
+    game.move(unit, {0, 5});
+
+    UpdateTimes(game, 10);
+    REQUIRE_THAT(game.position_of(unit), CloseTo({0, 5}));
+    REQUIRE(game.active_command_for(unit) == Command::None);
+  }
+
+  SECTION("where an attack is finished once its target has died") {
+    UnitProperties const victim_props = UnitProperties::Make().hit_points(2);
+    UnitProperties const attacker_props = UnitProperties::Make().attack_damage(1);
+    auto const victim = game.spawn_unit_at({1, 0}, victim_props);
+    auto const attacker = game.spawn_unit_at({5, 0}, attacker_props);
+    game.attack(attacker, victim);
+    game.queue_move(attacker, {5, 10});
+
+    UpdateTimes(game, 2);
+    REQUIRE(game.active_command_for(attacker) == Command::Move);
+
+    UpdateTimes(game, 10);
+    REQUIRE_THAT(game.position_of(attacker), CloseTo({5, 10}));
+  }
+}
+
+
+TEST_CASE("A game publishes the state of its units at the end of each update") {
+  auto game = Game{};
+  UnitProperties const props = UnitProperties::Make().hit_points(7);
+  auto const unit = game.spawn_unit_at({0, 0}, props);
+  game.move(unit, {10, 0});
+
+  REQUIRE(game.unit_states()->empty());
+
+  UpdateTimes(game, 1);
+  auto const view = game.unit_states();
+  REQUIRE(view->size() == 1);
+
+  auto const& state = view->front();
+  REQUIRE(state.ref == unit);
+  REQUIRE(state.location == Location{1, 0});
+  REQUIRE(state.hit_points == 7);
+  REQUIRE(state.command == Command::Move);
+
+  SECTION("which stays unchanged while it is being read") {
+    UpdateTimes(game, 1);
+    REQUIRE(view->front().location == Location{1, 0});
+    REQUIRE(game.unit_states()->front().location == Location{2, 0});
+  }
+}
+
+
+TEST_CASE("A game accounts for the memory of its subsystems") {
+  auto upstream = memory::CountingResource{};
+  auto game = Game{256, 256, &upstream};
+  auto const unit = game.spawn_unit_at({0, 0}, {});
+  REQUIRE(game.allocation_stats().units.allocations > 0);
+
+  for (auto i = 1; i <= 10; ++i) {
+    game.queue_move(unit, {static_cast<float>(i), 0});
+  }
+  REQUIRE(game.allocation_stats().commands.allocations > 0);
+
+  UpdateTimes(game, 1);
+  REQUIRE(game.allocation_stats().states.allocations > 0);
+  REQUIRE(upstream.counters().allocations > 0);
+}
+
+
+TEST_CASE("A game in steady state does not allocate during updates") {
+  auto game = Game{512, 512};
+  auto const WarmUpTicks = 3;
+
+  SECTION("when units are moving") {
+    for (auto i = 0; i < 20; ++i) {
+      auto const unit = game.spawn_unit_at({1.0f * i, 0}, {});
+      for (auto j = 1; j <= 10; ++j) {
+        game.queue_move(unit, {1.0f * i, 10.0f * j});
+      }
+    }
+
+    UpdateTimes(game, WarmUpTicks);
+    game.forbid_allocations_in_update(true);
+    REQUIRE_NOTHROW(UpdateTimes(game, 100));
+  }
+
+  SECTION("when units are fighting") {
+    UnitProperties const props =
+        UnitProperties::Make()
+            .hit_points(1000)
+            .attack_damage(1)
+            .attack_radius(5)
+    ;
+    for (auto i = 0; i < 10; ++i) {
+      auto const left = game.spawn_unit_at({10, 20.0f * i}, props);
+      auto const right = game.spawn_unit_at({100, 20.0f * i}, props);
+      game.attack(left, right);
+      game.attack(right, left);
+    }
+
+    UpdateTimes(game, WarmUpTicks);
+    game.forbid_allocations_in_update(true);
+    REQUIRE_NOTHROW(UpdateTimes(game, 100));
+  }
+
+  SECTION("but is reported if it does") {
+    game.forbid_allocations_in_update(true);
+    game.spawn_unit_at({0, 0}, {});
+    REQUIRE_THROWS_AS(UpdateTimes(game, 1), SteadyStateAllocation);
+  }
+}
+
+
+TEST_CASE("Units outside of every interest area are simulated less often") {
+  auto game = Game{};
+  game.simulate_far_units_every(4);
+  game.set_interest_areas({geometry::Rectangle{0, 0, 10, 10}});
+
+  SECTION("taking several steps at once") {
+    auto const unit = game.spawn_unit_at({20, 20}, {});
+    game.move(unit, {120, 20});
+
+    UpdateTimes(game, 8);
+    REQUIRE(game.position_of(unit) == Location{28, 20});
+
+    SECTION("but still arriving at their destination") {
+      UpdateTimes(game, 100);
+      REQUIRE(game.position_of(unit) == Location{120, 20});
+      REQUIRE(game.active_command_for(unit) == Command::None);
+    }
+
+    SECTION("until they are simulated at full rate again") {
+      game.simulate_far_units_every(1);
+      UpdateTimes(game, 3);
+      REQUIRE(game.position_of(unit) == Location{31, 20});
+    }
+  }
+
+  SECTION("while units within an interest area are updated on every tick") {
+    auto const unit = game.spawn_unit_at({0, 5}, {});
+    game.move(unit, {100, 5});
+
+    UpdateTimes(game, 3);
+    REQUIRE(game.position_of(unit) == Location{3, 5});
+  }
+
+  SECTION("except for attacks, which are always resolved") {
+    UnitProperties const victim_props = UnitProperties::Make().hit_points(10);
+    UnitProperties const attacker_props = UnitProperties::Make().attack_damage(1);
+    auto const victim = game.spawn_unit_at({50, 50}, victim_props);
+    auto const attacker = game.spawn_unit_at({60, 50}, attacker_props);
+    game.attack(attacker, victim);
+
+    UpdateTimes(game, 3);
+    REQUIRE(game.unit(victim).hit_points() == 7);
+  }
+}
+
+
+TEST_CASE("Units belong to players with non-negative indices") {
+  REQUIRE_THROWS_AS(UnitProperties::Make().owner(-1), std::invalid_argument);
+  REQUIRE(UnitProperties{UnitProperties::Make().owner(3)}.owner() == 3);
+}
+
+
+TEST_CASE("A game can keep track of the influence of each player") {
+  auto game = Game{100, 100};
+  game.track_influence(10, 50, 2);
+
+  UnitProperties const soldier =
+      UnitProperties::Make()
+          .owner(1)
+          .hit_points(10)
+          .attack_damage(4)
+          .attack_radius(20)
+  ;
+  auto const unit = game.spawn_unit_at({5, 5}, soldier);
+  REQUIRE(game.influence().at(1, {5, 5}) == Approx(4));
+  REQUIRE(game.influence().at(0, {5, 5}) == 0);
+
+  SECTION("of a limited number of players") {
+    UnitProperties const stranger = UnitProperties::Make().owner(2);
+    REQUIRE_THROWS_AS(game.spawn_unit_at({5, 5}, stranger), std::out_of_range);
+
+    auto const kinds = std::vector<UnitProperties>{stranger};
+    auto const requests = std::vector<SpawnRequest>{{{5, 5}, 0}};
+    auto refs = std::vector<Game::UnitRef>(1);
+    REQUIRE_THROWS_AS(game.spawn_units(kinds, requests, refs), std::out_of_range);
+    REQUIRE_THROWS_AS(game.track_influence(10, 50, 1), std::out_of_range);
+  }
+
+  SECTION("following units as they move") {
+    game.move(unit, {55, 5});
+    UpdateTimes(game, 50);
+    REQUIRE(game.influence().at(1, {5, 5}) == 0);
+    REQUIRE(game.influence().at(1, {55, 5}) == Approx(4));
+  }
+
+  SECTION("weakening units as they take damage") {
+    UnitProperties const enemy = UnitProperties::Make().owner(0).attack_damage(5);
+    auto const attacker = game.spawn_unit_at({10, 10}, enemy);
+    game.attack(attacker, unit);
+
+    UpdateTimes(game, 1);
+    REQUIRE(game.influence().at(1, {5, 5}) == Approx(2));
+
+    SECTION("and removing them when they die") {
+      UpdateTimes(game, 1);
+      REQUIRE(game.influence().total_in(1, {0, 0, 100, 100}) == 0);
+    }
+
+    SECTION("and keeping them weakened when handed over to another game") {
+      auto other = Game{100, 100};
+      other.track_influence(10, 50, 2);
+      auto leaving = std::vector<Game::DetachedUnit>{};
+      game.detach_units_outside({50, 50, 100, 100}, leaving);
+      REQUIRE(leaving.size() == 2);
+      for (auto& detached : leaving) {
+        other.attach_unit(std::move(detached));
+      }
+      REQUIRE(other.influence().at(1, {5, 5}) == Approx(2));
+    }
+  }
+}
+
+
+TEST_CASE("A game spawns units in bulk") {
+  auto game = Game{100, 100};
+  UnitProperties const soldier = UnitProperties::Make().owner(1).hit_points(10);
+  UnitProperties const tank = UnitProperties::Make()
+      .owner(2)
+      .shape(UnitShape::AABB{2, 1});
+  auto const kinds = std::vector<UnitProperties>{soldier, tank};
+
+  auto refs = std::vector<Game::UnitRef>(3, Game::UnitRef{-1});
+
+  SECTION("with the kinds and at the positions requested") {
+    auto const requests = std::vector<SpawnRequest>{
+      {{10, 10}, 0},
+      {{20, 10}, 1},
+      {{30, 10}, 0},
+    };
+    game.spawn_units(kinds, requests, refs);
+
+    REQUIRE(refs[1].id == refs[0].id + 1);
+    REQUIRE(refs[2].id == refs[1].id + 1);
+    REQUIRE(game.position_of(refs[1]) == Location{20, 10});
+    REQUIRE(game.unit(refs[0]).owner() == 1);
+    REQUIRE(game.unit(refs[1]).owner() == 2);
+    REQUIRE(game.unit(refs[2]).hit_points() == 10);
+
+    SECTION("which are then simulated like any other") {
+      game.move(refs[1], {20, 50});
+      UpdateTimes(game, 40);
+      REQUIRE(game.position_of(refs[1]) == Location{20, 50});
+    }
+  }
+
+  SECTION("or not at all if any of the requests is invalid") {
+    auto const outside = std::vector<SpawnRequest>{
+      {{10, 10}, 0},
+      {{200, 10}, 0},
+    };
+    REQUIRE_THROWS_AS(game.spawn_units(kinds, outside, refs), InvalidPosition);
+
+    auto const unknown_kind = std::vector<SpawnRequest>{
+      {{10, 10}, 0},
+      {{20, 10}, 2},
+    };
+    REQUIRE_THROWS_AS(game.spawn_units(kinds, unknown_kind, refs), std::out_of_range);
+
+    REQUIRE(refs[0].id == -1);
+    auto positions = Game::PositionSnapshot{};
+    game.snapshot_positions(positions);
+    REQUIRE(positions.empty());
+  }
+}
@@ -1,6 +1,7 @@
 #include "game.h"
 #include "geometry.h"
 
+#include "small_queue.h"
 #include "variant.h"
 
 #include <algorithm>
@@ -8,6 +9,8 @@
 #include <cmath>
 #include <limits>
 #include <stdexcept>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <variant>
 
@@ -34,12 +37,66 @@ namespace game {
   >;
 
 
+  // Orders beyond this many per unit are kept in the game's command pool.
+  constexpr auto InlineCommandCount = std::size_t{4};
+  using CommandQueue = container::SmallQueue<UnitCommand, InlineCommandCount>;
+
+
   struct Unit {
+    Game::UnitRef ref{-1};
     Location location;
-    UnitCommand command{commands::Idle{}};
+    CommandQueue commands;
     UnitProperties props;
     float velocity_{0.0f};
-    Unit(Location l, UnitProperties p) : location{l}, props{p} {}
+    bool outside_interest{false};
+    bool dead{false};
+    std::size_t shape_list{0};
+    std::size_t shape_group_index{0};
+
+    int const max_hit_points;
+    struct InfluenceStamp {
+      bool stamped{false};
+      Location location;
+      float strength;
+    } influence;
+
+    Unit(Location l, UnitProperties p, std::pmr::memory_resource* pool)
+        : Unit{l, p, p.hit_points(), pool} {}
+
+    Unit(Location l, UnitProperties p, int max_hp, std::pmr::memory_resource* pool)
+        : location{l}, commands{pool}, props{p}, max_hit_points{max_hp} {}
+
+    auto influence_strength() const -> float {
+      if (max_hit_points <= 0 || props.hit_points() <= 0) {
+        return 0.0f;
+      }
+      return props.attack_damage()
+          * (static_cast<float>(props.hit_points()) / max_hit_points);
+    }
+
+    auto command() const -> UnitCommand {
+      if (commands.empty()) {
+        return commands::Idle{};
+      }
+      return commands.front();
+    }
+
+    auto active_command() const -> Command {
+      if (commands.empty()) {
+        return Command::None;
+      }
+      return variant::Match(commands.front(),
+          [](commands::Idle const&) -> Command { return Command::None; },
+          [](commands::Move const&) -> Command { return Command::Move; },
+          [](commands::Attack const&) -> Command { return Command::Attack; }
+      );
+    }
+
+    void command_finished() {
+      if (!commands.empty()) {
+        commands.pop_front();
+      }
+    }
 
     void take_damage(int v) {
       props.hit_points_ -= v;
@@ -47,77 +104,332 @@ namespace game {
   };
 
 
-  Game::Game() = default;
-  Game::Game(float width, float height) : map_dimensions_{width, height} {}
+  Game::Game() : Game{std::pmr::get_default_resource()} {}
+  Game::Game(float width, float height)
+      : Game{width, height, std::pmr::get_default_resource()} {}
+
+  Game::Game(std::pmr::memory_resource* upstream)
+      : units_memory_{upstream}
+      , commands_memory_{upstream}
+      , states_memory_{upstream}
+      , units_{&unit_pool_}
+      , shape_groups_{std::allocator_arg, std::pmr::polymorphic_allocator<>{&unit_pool_}}
+      , casualties_{&unit_pool_}
+      , regroup_{&unit_pool_}
+  {
+    rebuild_shape_groups();
+  }
+
+  Game::Game(float width, float height, std::pmr::memory_resource* upstream)
+      : units_memory_{upstream}
+      , commands_memory_{upstream}
+      , states_memory_{upstream}
+      , units_{&unit_pool_}
+      , map_dimensions_{width, height}
+      , shape_groups_{std::allocator_arg, std::pmr::polymorphic_allocator<>{&unit_pool_}}
+      , casualties_{&unit_pool_}
+      , regroup_{&unit_pool_}
+  {
+    rebuild_shape_groups();
+  }
+
   Game::~Game() = default;
 
   auto Game::position_of(UnitRef ref) const -> Location {
     return units_.at(ref.id)->location;
   }
 
-  auto Game::spawn_unit_at(Location location, UnitProperties const& props) -> UnitRef {
-    static auto CurrentUnitID = std::atomic_int32_t{0};
-    if (CurrentUnitID == std::numeric_limits<int>::max()) {
-      throw std::runtime_error("Unit ID overflow, cannot create a new one!");
+  namespace {
+    auto NextUnitID = std::atomic_int32_t{0};
+
+    // Take count consecutive unit IDs, returning the first one.
+    auto ReserveUnitIDs(std::size_t count) -> int {
+      auto constexpr Last = std::numeric_limits<int>::max();
+      auto first = NextUnitID.load();
+      do {
+        if (count > static_cast<std::size_t>(Last - first)) {
+          throw std::runtime_error("Unit ID overflow, cannot create a new one!");
+        }
+      } while (!NextUnitID.compare_exchange_weak(
+          first, first + static_cast<int>(count)
+      ));
+      return first;
     }
+  }
+
 
+  auto Game::spawn_unit_at(Location location, UnitProperties const& props) -> UnitRef {
     auto const rect = Rectangle{map_dimensions_};
     if (!Contains(rect, location)) {
       throw InvalidPosition{};
     }
 
-    auto const ref = UnitRef{CurrentUnitID++};
-    units_[ref.id] = std::make_unique<Unit>(location, props);
+    check_influence_owner(props);
+
+    auto const ref = UnitRef{ReserveUnitIDs(1)};
+    place_unit(ref, location, props);
     return ref;
   }
 
 
+  void Game::spawn_units(
+      std::span<UnitProperties const> kinds,
+      std::span<SpawnRequest const> requests,
+      std::span<UnitRef> refs
+  ) {
+    if (refs.size() < requests.size()) {
+      throw std::invalid_argument("Not enough room for the spawned unit references!");
+    }
+
+    // Check everything in one branch-free pass the compiler can vectorise,
+    // and only then work out what was wrong. Positions are checked like in
+    // spawn_unit_at().
+    auto const map = Rectangle{map_dimensions_};
+    auto const kind_count = kinds.size();
+    auto invalid = 0;
+    for (auto const& request : requests) {
+      invalid += !(Contains(map, request.location) & (request.kind < kind_count));
+    }
+    if (invalid > 0) {
+      auto const unknown_kind = std::any_of(requests.begin(), requests.end(),
+          [kind_count](SpawnRequest const& request) { return request.kind >= kind_count; }
+      );
+      if (unknown_kind) {
+        throw std::out_of_range("Unknown unit kind in spawn request!");
+      }
+      throw InvalidPosition{};
+    }
+    for (auto const& kind : kinds) {
+      check_influence_owner(kind);
+    }
+
+    auto const first_id = ReserveUnitIDs(requests.size());
+
+    // Count the units going to each list of each shape group, which with
+    // far units simulated less often is one list per time slice.
+    units_.reserve(units_.size() + requests.size());
+    auto const lists = std::get<0>(shape_groups_).size();
+    auto list_counts = std::vector<std::size_t>(std::variant_size_v<Shape> * lists);
+    for (auto index = std::size_t{0}; index < requests.size(); ++index) {
+      auto const& request = requests[index];
+      auto const outside_interest =
+          far_update_period_ > 1 && !within_interest(request.location);
+      auto const list = shape_list_for(first_id + static_cast<int>(index), outside_interest);
+      ++list_counts[kinds[request.kind].shape().index() * lists + list];
+    }
+    std::apply([&list_counts, lists](auto&... groups) {
+      auto counts = list_counts.begin();
+      ([&groups, &counts, lists] {
+        for (auto list = std::size_t{0}; list < lists; ++list, ++counts) {
+          groups[list].reserve(groups[list].size() + *counts);
+        }
+      }(), ...);
+    }, shape_groups_);
+
+    auto id = first_id;
+    for (auto index = std::size_t{0}; index < requests.size(); ++index, ++id) {
+      auto const& request = requests[index];
+      refs[index] = UnitRef{id};
+      place_unit(refs[index], request.location, kinds[request.kind]);
+    }
+  }
+
+
+  void Game::place_unit(UnitRef ref, Location location, UnitProperties const& props) {
+    auto unit = memory::MakeUnique<Unit>(&unit_pool_, location, props, &command_pool_);
+    unit->ref = ref;
+    unit->outside_interest = far_update_period_ > 1 && !within_interest(location);
+    add_to_shape_group(*unit);
+    stamp_influence(*unit);
+    units_.emplace(ref.id, std::move(unit));
+  }
+
+
+  auto Game::shape_list_for(Unit const& unit) const -> std::size_t {
+    if (unit.active_command() == Command::Attack) {
+      return 0;
+    }
+    return shape_list_for(unit.ref.id, unit.outside_interest);
+  }
+
+
+  auto Game::shape_list_for(int id, bool outside_interest) const -> std::size_t {
+    if (far_update_period_ > 1 && outside_interest) {
+      return 1 + static_cast<std::size_t>(id % far_update_period_);
+    }
+    return 0;
+  }
+
+
+  void Game::add_to_shape_group(Unit& unit) {
+    std::visit([this, &unit](auto const& shape) {
+      using ShapeType = std::decay_t<decltype(shape)>;
+      auto& list = std::get<ShapeGroup<ShapeType>>(shape_groups_)[shape_list_for(unit)];
+      unit.shape_list = shape_list_for(unit);
+      unit.shape_group_index = list.size();
+      list.push_back({&unit, shape});
+    }, unit.props.shape());
+  }
+
+
+  void Game::remove_from_shape_group(Unit& unit) {
+    std::visit([this, &unit](auto const& shape) {
+      using ShapeType = std::decay_t<decltype(shape)>;
+      auto& list = std::get<ShapeGroup<ShapeType>>(shape_groups_)[unit.shape_list];
+      list[unit.shape_group_index] = list.back();
+      list[unit.shape_group_index].unit->shape_group_index = unit.shape_group_index;
+      list.pop_back();
+    }, unit.props.shape());
+  }
+
+
+  void Game::regroup(Unit& unit) {
+    if (walking_shape_groups_) {
+      regroup_.push_back(&unit);
+    }
+    else if (shape_list_for(unit) != unit.shape_list) {
+      remove_from_shape_group(unit);
+      add_to_shape_group(unit);
+    }
+  }
+
+
+  void Game::apply_regroups() {
+    for (auto* const unit : regroup_) {
+      if (!unit->dead && shape_list_for(*unit) != unit->shape_list) {
+        remove_from_shape_group(*unit);
+        add_to_shape_group(*unit);
+      }
+    }
+    regroup_.clear();
+  }
+
+
+  void Game::rebuild_shape_groups() {
+    auto const lists = far_update_period_ > 1 ? 1 + far_update_period_ : 1;
+    std::apply([lists](auto&... groups) {
+      ((groups.clear(), groups.resize(lists)), ...);
+    }, shape_groups_);
+    for (auto& [id, unit_ptr] : units_) {
+      add_to_shape_group(*unit_ptr);
+    }
+  }
+
+
   void Game::move(UnitRef ref, Location location) {
-    units_.at(ref.id)->command = commands::Move{location};
+    auto& unit = *units_.at(ref.id);
+    unit.commands.clear();
+    unit.commands.push_back(commands::Move{location});
+    regroup(unit);
+  }
+
+
+  void Game::queue_move(UnitRef ref, Location location) {
+    auto& unit = *units_.at(ref.id);
+    unit.commands.push_back(commands::Move{location});
+    regroup(unit);
   }
 
 
   void Game::be_idle(Unit&) {}
 
-  void Game::do_move(Unit& unit, commands::Move const& move) {
-    auto const direction = Normalized(move.loc - unit.location);
+  void Game::finish_command(Unit& unit) {
+    if (unit.commands.empty()) {
+      return;
+    }
+    unit.command_finished();
+    if (listener_) {
+      listener_->command_finished(unit.ref);
+    }
+    note_foreign_target(unit);
+  }
+
+
+  void Game::note_foreign_target(Unit const& unit) {
+    auto const command = unit.command();
+    if (auto const* attack = std::get_if<commands::Attack>(&command);
+        attack && units_.count(attack->target.id) == 0) {
+      foreign_targets_.push_back({unit.ref, attack->target});
+    }
+  }
+
+
+  void Game::drop_attack(UnitRef attacker, UnitRef target) {
+    auto const it = units_.find(attacker.id);
+    if (it == units_.end()) {
+      return;
+    }
+    auto& unit = *it->second;
+    auto const command = unit.command();
+    if (auto const* attack = std::get_if<commands::Attack>(&command);
+        attack && attack->target.id == target.id) {
+      finish_command(unit);
+      regroup(unit);
+    }
+  }
+
+  template<typename ShapeType>
+  void Game::do_move(
+      Unit& unit, ShapeType const& shape, commands::Move const& move, int steps
+  ) {
+    auto const to_target = move.loc - unit.location;
+    auto const remaining = LengthOf(to_target);
     unit.velocity_ = std::min(
-        unit.velocity_ + unit.props.acceleration(),
+        unit.velocity_ + steps * unit.props.acceleration(),
         unit.props.velocity()
     );
-    auto const new_location = unit.location + unit.velocity_ * direction;
-    auto const unit_radius = std::get<UnitShape::Circle>(unit.props.shape()).radius;
+    auto const step = std::min(steps * unit.velocity_, remaining);
+    auto const new_location = remaining > 0.0f
+        ? unit.location + step * (to_target / remaining)
+        : move.loc;
     auto const available_area = geometry::ContractedBy(
         Rectangle{map_dimensions_},
-        unit_radius
+        UnitShape::HalfExtentsOf(shape)
     );
     unit.location = geometry::Clip(available_area, new_location);
 
     auto const displacement = unit.location - move.loc;
     auto const distance_to_target = LengthOf(displacement);
     if (distance_to_target < 0.0001f) {
-      unit.command = commands::Idle{};
+      finish_command(unit);
     }
   }
 
 
   void Game::do_attack(Unit& unit, commands::Attack const& attack) {
-    auto& target = *units_.at(attack.target.id);
-    auto const distance = LengthOf(target.location - unit.location);
+    auto* target = static_cast<Unit*>(nullptr);
+    auto target_location = Location{};
+    auto const local = units_.find(attack.target.id);
+    if (local != units_.end() && !local->second->dead) {
+      target = local->second.get();
+      target_location = target->location;
+    }
+    else if (auto const* foreign = find_in_halo(attack.target)) {
+      foreign_targets_.push_back({unit.ref, attack.target});
+      target_location = foreign->location;
+    }
+    else if (local == units_.end() && keep_unseen_targets_) {
+      foreign_targets_.push_back({unit.ref, attack.target});
+      return;
+    }
+    else {
+      finish_command(unit);
+      return;
+    }
+
+    auto const distance = LengthOf(target_location - unit.location);
     if (distance <= unit.props.attack_radius()) {
-      target.take_damage(unit.props.attack_damage());
-      if (target.props.hit_points() <= 0) {
-        if (listener_) {
-          listener_->casualty(attack.target);
-          units_.erase(attack.target.id);
-        }
+      if (!target) {
+        foreign_damage_.push_back({
+          attack.target, static_cast<int>(unit.props.attack_damage())
+        });
       }
-      else if (listener_) {
-        listener_->damage(attack.target);
+      else if (inflict_damage(*target, unit.props.attack_damage())) {
+        finish_command(unit);
       }
     }
     else {
-      auto const direction = Normalized(target.location - unit.location);
+      auto const direction = Normalized(target_location - unit.location);
       unit.velocity_ = std::min(
           unit.velocity_ + unit.props.acceleration(),
           unit.props.velocity()
@@ -127,31 +439,346 @@ namespace game {
   }
 
 
-  void Game::update() {
-    for (auto& [id, unit_ptr] : units_) {
+  auto Game::inflict_damage(Unit& target, int amount) -> bool {
+    target.take_damage(amount);
+    stamp_influence(target);
+    if (target.props.hit_points() <= 0) {
+      target.dead = true;
+      casualties_.push_back(&target);
+      if (listener_) {
+        listener_->casualty(target.ref);
+      }
+      return true;
+    }
+
+    if (listener_) {
+      listener_->damage(target.ref);
+    }
+    return false;
+  }
+
+
+  void Game::erase_casualties() {
+    for (auto* const unit : casualties_) {
+      remove_from_shape_group(*unit);
+      unstamp_influence(*unit);
+      units_.erase(unit->ref.id);
+    }
+    casualties_.clear();
+  }
+
+
+  void Game::apply_damage(UnitRef ref, int amount) {
+    if (auto const it = units_.find(ref.id); it != units_.end() && !it->second->dead) {
+      inflict_damage(*it->second, amount);
+      erase_casualties();
+    }
+  }
+
+
+  Game::DetachedUnit::DetachedUnit(UnitRef ref, UnitPtr unit)
+      : ref_{ref}, unit_{std::move(unit)} {}
+  Game::DetachedUnit::DetachedUnit(DetachedUnit&&) noexcept = default;
+  auto Game::DetachedUnit::operator=(DetachedUnit&&) noexcept -> DetachedUnit& = default;
+  Game::DetachedUnit::~DetachedUnit() = default;
+
+  auto Game::DetachedUnit::location() const -> Location {
+    return unit_->location;
+  }
+
+
+  void Game::detach_units_outside(
+      Rectangle const& area, std::vector<DetachedUnit>& leaving
+  ) {
+    for (auto it = units_.begin(); it != units_.end();) {
+      if (Contains(area, it->second->location)) {
+        ++it;
+        continue;
+      }
+      remove_from_shape_group(*it->second);
+      unstamp_influence(*it->second);
+      leaving.push_back(DetachedUnit{UnitRef{it->first}, std::move(it->second)});
+      it = units_.erase(it);
+    }
+  }
+
+
+  void Game::attach_unit(DetachedUnit&& detached) {
+    auto& source = *detached.unit_;
+    auto unit = memory::MakeUnique<Unit>(
+        &unit_pool_, source.location, source.props, source.max_hit_points, &command_pool_
+    );
+    unit->ref = detached.ref_;
+    unit->velocity_ = source.velocity_;
+    unit->outside_interest = source.outside_interest;
+    for (; !source.commands.empty(); source.commands.pop_front()) {
+      unit->commands.push_back(source.commands.front());
+    }
+    add_to_shape_group(*unit);
+    stamp_influence(*unit);
+    note_foreign_target(*unit);
+    units_.emplace(detached.ref_.id, std::move(unit));
+    detached.unit_.reset();
+  }
+
+
+  auto Game::within_interest(Location const& location) const -> bool {
+    return std::any_of(
+        interest_areas_.begin(), interest_areas_.end(),
+        [&location](Rectangle const& area) { return Contains(area, location); }
+    );
+  }
+
+
+  template<typename ShapeType>
+  void Game::update_shape_group(ShapeGroup<ShapeType>& group) {
+    update_shape_list(group.front(), false);
+    if (far_update_period_ > 1) {
+      auto const due = (far_update_period_ - tick_ % far_update_period_) % far_update_period_;
+      update_shape_list(group[1 + static_cast<std::size_t>(due)], true);
+    }
+  }
+
+
+  template<typename ShapeType>
+  void Game::update_shape_list(ShapeList<ShapeType> const& list, bool far) {
+    for (auto const& [unit_ptr, shape] : list) {
       auto& unit = *unit_ptr;
-      variant::Match(unit.command,
+      if (unit.dead) {
+        continue;
+      }
+
+      auto const time_slice = far || (tick_ + unit.ref.id) % far_update_period_ == 0;
+      if (time_slice) {
+        unit.outside_interest = far_update_period_ > 1
+            && !within_interest(unit.location);
+      }
+
+      variant::Match(unit.command(),
           [this, &unit](commands::Idle const& idle) { be_idle(unit); },
-          [this, &unit](commands::Move const& move) { do_move(unit, move); },
+          [this, &unit, &shape, time_slice](commands::Move const& move) {
+            if (!unit.outside_interest) {
+              do_move(unit, shape, move, 1);
+            }
+            else if (time_slice) {
+              do_move(unit, shape, move, far_update_period_);
+            }
+          },
           [this, &unit](commands::Attack const& attack) { do_attack(unit, attack); }
       );
+      stamp_influence(unit);
+
+      if (shape_list_for(unit) != unit.shape_list) {
+        regroup_.push_back(&unit);
+      }
+    }
+  }
+
+
+  template<std::size_t... ShapeIndex>
+  void Game::update_shape_groups(std::index_sequence<ShapeIndex...>) {
+    (update_shape_group<std::variant_alternative_t<ShapeIndex, Shape>>(
+        std::get<ShapeIndex>(shape_groups_)
+    ), ...);
+  }
+
+
+  void Game::update() {
+    auto const allocations_before = allocation_count();
+    std::sort(halo_.begin(), halo_.end(), [](HaloUnit const& lhs, HaloUnit const& rhs) {
+      return lhs.ref.id < rhs.ref.id;
+    });
+    halo_.erase(std::unique(halo_.begin(), halo_.end(),
+        [](HaloUnit const& lhs, HaloUnit const& rhs) { return lhs.ref.id == rhs.ref.id; }
+    ), halo_.end());
+    foreign_targets_.clear();
+    walking_shape_groups_ = true;
+    update_shape_groups(std::make_index_sequence<std::variant_size_v<Shape>>{});
+    walking_shape_groups_ = false;
+    apply_regroups();
+    erase_casualties();
+    ++tick_;
+    publish_states();
+
+    if (forbid_allocations_ && allocation_count() != allocations_before) {
+      throw SteadyStateAllocation{};
+    }
+  }
+
+
+  void Game::publish_states() {
+    auto* const states = published_states_.acquire_write();
+    if (!states) {
+      return;
+    }
+
+    states->clear();
+    states->reserve(units_.size());
+    for (auto const& [id, unit_ptr] : units_) {
+      auto const& unit = *unit_ptr;
+      states->push_back({
+          UnitRef{id},
+          unit.props.owner(),
+          unit.location,
+          unit.props.hit_points(),
+          unit.active_command(),
+      });
+    }
+    published_states_.publish();
+  }
+
+
+  void Game::simulate_far_units_every(int period) {
+    if (period <= 0) {
+      throw std::invalid_argument("Update period must be positive!");
+    }
+    far_update_period_ = period;
+    rebuild_shape_groups();
+  }
+
+
+  void Game::set_interest_areas(std::vector<Rectangle> areas) {
+    interest_areas_ = std::move(areas);
+  }
+
+
+  void Game::track_influence(float cell_size, float max_radius, int max_players) {
+    auto const beyond = std::any_of(units_.begin(), units_.end(),
+        [max_players](auto const& entry) { return entry.second->props.owner() >= max_players; }
+    );
+    if (beyond) {
+      throw std::out_of_range("A unit's owner is beyond the players tracked!");
+    }
+
+    influence_.emplace(map_dimensions_, cell_size, max_radius, max_players, &units_memory_);
+    for (auto& [id, unit_ptr] : units_) {
+      unit_ptr->influence.stamped = false;
+      stamp_influence(*unit_ptr);
     }
   }
 
+
+  auto Game::influence() const -> InfluenceMap const& {
+    if (!influence_) {
+      throw std::logic_error("Influence is not tracked in this game!");
+    }
+    return *influence_;
+  }
+
+
+  void Game::check_influence_owner(UnitProperties const& props) const {
+    if (influence_ && props.owner() >= influence_->max_players()) {
+      throw std::out_of_range("A unit's owner is beyond the players tracked!");
+    }
+  }
+
+
+  void Game::stamp_influence(Unit& unit) {
+    if (!influence_) {
+      return;
+    }
+
+    auto const strength = unit.influence_strength();
+    auto& stamp = unit.influence;
+    if (stamp.stamped
+        && stamp.strength == strength
+        && influence_->same_cell(stamp.location, unit.location)) {
+      return;
+    }
+
+    unstamp_influence(unit);
+    influence_->add(unit.props.owner(), unit.location, strength, unit.props.attack_radius());
+    stamp = {true, unit.location, strength};
+  }
+
+
+  void Game::unstamp_influence(Unit& unit) {
+    auto& stamp = unit.influence;
+    if (!influence_ || !stamp.stamped) {
+      return;
+    }
+    influence_->remove(
+        unit.props.owner(), stamp.location, stamp.strength, unit.props.attack_radius()
+    );
+    stamp.stamped = false;
+  }
+
+
+  void Game::snapshot_positions(PositionSnapshot& snapshot) const {
+    auto& entries = snapshot.entries_;
+    entries.clear();
+    entries.reserve(units_.size());
+    for (auto const& [id, unit_ptr] : units_) {
+      entries.push_back({id, unit_ptr->location});
+    }
+    std::sort(entries.begin(), entries.end(),
+        [](auto const& lhs, auto const& rhs) { return lhs.id < rhs.id; }
+    );
+  }
+
+
+  auto Game::PositionSnapshot::find(UnitRef ref) const -> Location const* {
+    auto const found = std::lower_bound(entries_.begin(), entries_.end(), ref.id,
+        [](Entry const& entry, int id) { return entry.id < id; }
+    );
+    return found != entries_.end() && found->id == ref.id ? &found->location : nullptr;
+  }
+
+
+  void Game::append_positions_within(Rectangle const& area, Halo& halo) const {
+    for (auto const& [id, unit_ptr] : units_) {
+      if (Contains(area, unit_ptr->location)) {
+        halo.push_back({UnitRef{id}, unit_ptr->location});
+      }
+    }
+  }
+
+
+  auto Game::find_in_halo(UnitRef ref) const -> HaloUnit const* {
+    auto const found = std::lower_bound(halo_.begin(), halo_.end(), ref.id,
+        [](HaloUnit const& unit, int id) { return unit.ref.id < id; }
+    );
+    return found != halo_.end() && found->ref.id == ref.id ? &*found : nullptr;
+  }
+
   
   auto Game::active_command_for(UnitRef ref) const -> Command {
-    auto const& unit = *units_.at(ref.id);
-    return variant::Match(unit.command,
-        [](commands::Idle const&) -> Command { return Command::None; },
-        [](commands::Move const&) -> Command { return Command::Move; },
-        [](commands::Attack const&) -> Command { return Command::Attack; }
-    );
+    return units_.at(ref.id)->active_command();
   }
 
   
   void Game::attack(UnitRef attacker_ref, UnitRef target_ref) {
     auto& attacker = *units_.at(attacker_ref.id);
-    attacker.command = commands::Attack{target_ref};
+    attacker.commands.clear();
+    attacker.commands.push_back(commands::Attack{target_ref});
+    regroup(attacker);
+    note_foreign_target(attacker);
+  }
+
+
+  void Game::queue_attack(UnitRef attacker_ref, UnitRef target_ref) {
+    auto& attacker = *units_.at(attacker_ref.id);
+    attacker.commands.push_back(commands::Attack{target_ref});
+    regroup(attacker);
+    if (attacker.commands.size() == 1) {
+      note_foreign_target(attacker);
+    }
+  }
+
+
+  auto Game::allocation_count() const -> std::size_t {
+    return units_memory_.counters().allocations
+        + commands_memory_.counters().allocations
+        + states_memory_.counters().allocations;
+  }
+
+
+  auto Game::allocation_stats() const -> AllocationStats {
+    return {
+      units_memory_.counters(),
+      commands_memory_.counters(),
+      states_memory_.counters(),
+    };
   }
 
 
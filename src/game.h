@@ -1,9 +1,19 @@
 #pragma once
 
 #include "geometry.h"
+#include "influence_map.h"
+#include "memory.h"
+#include "triple_buffer.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <limits>
 #include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
 #include <variant>
@@ -15,6 +25,12 @@ namespace game {
     InvalidPosition() : std::runtime_error("Position is out of bounds!") {}
   };
 
+  class SteadyStateAllocation : public std::runtime_error {
+  public:
+    SteadyStateAllocation()
+        : std::runtime_error("Game update allocated memory in steady state!") {}
+  };
+
 
   enum class Command {
     None,
@@ -26,14 +42,48 @@ namespace game {
     struct Circle {
       float radius;
     };
+
+    struct AABB {
+      float half_width;
+      float half_height;
+    };
+
+    // Two half-circles joined by a rectangle, lying along the x axis.
+    struct Capsule {
+      float radius;
+      float half_length;
+    };
+
+    // How far a shape reaches from the unit's location along each axis.
+    inline auto HalfExtentsOf(Circle const& c) noexcept -> geometry::Size {
+      return {c.radius, c.radius};
+    }
+
+    inline auto HalfExtentsOf(AABB const& b) noexcept -> geometry::Size {
+      return {b.half_width, b.half_height};
+    }
+
+    inline auto HalfExtentsOf(Capsule const& c) noexcept -> geometry::Size {
+      return {c.radius + c.half_length, c.radius};
+    }
   }
 
   using Shape = std::variant<
-      UnitShape::Circle
+      UnitShape::Circle,
+      UnitShape::AABB,
+      UnitShape::Capsule
   >;
 
 
   class Unit;
+
+  // One unit to create with Game::spawn_units(): where, and which of the
+  // given kinds of unit it is. Kept trivially copyable, so arrays of these
+  // can be read straight from a file (see scenario.h).
+  struct SpawnRequest {
+    geometry::Location location;
+    std::uint32_t kind;
+  };
   class UnitPropertiesBuilder;
 
   class UnitProperties {
@@ -43,6 +93,7 @@ namespace game {
     float velocity_{1.0f};
     Shape shape_;
     float acceleration_{std::numeric_limits<float>::infinity()};
+    int owner_{0};
 
   public:
     friend class Unit;
@@ -52,8 +103,9 @@ namespace game {
     auto attack_radius() const -> float { return attack_radius_; }
     auto attack_damage() const -> float { return attack_damage_; }
     auto velocity() const -> float { return velocity_; }
-    auto shape() const -> Shape { return shape_; }
+    auto shape() const -> Shape const& { return shape_; }
     auto acceleration() const -> float { return acceleration_; }
+    auto owner() const -> int { return owner_; }
 
     static auto Make() -> UnitPropertiesBuilder;
   };
@@ -95,6 +147,15 @@ namespace game {
       return *this;
     }
 
+    // Index of the player the unit belongs to; never negative.
+    auto owner(int value) -> ThisType& {
+      if (value < 0) {
+        throw std::invalid_argument("Unit owners must not be negative!");
+      }
+      props.owner_ = value;
+      return *this;
+    }
+
     operator UnitProperties&&() { return std::move(props); }
   };
 
@@ -116,12 +177,94 @@ namespace game {
     struct GameEvents {
       virtual void damage(UnitRef) = 0;
       virtual void casualty(UnitRef) = 0;
+      // A unit is done with its current command, either because it has
+      // carried it out or because its target is gone.
+      virtual void command_finished(UnitRef) {}
     };
     using GameEventsPtr = std::shared_ptr<GameEvents>;
 
+    // Packed copy of a unit's observable state, as of the end of a tick.
+    struct UnitState {
+      UnitRef ref;
+      int owner;
+      geometry::Location location;
+      int hit_points;
+      Command command;
+    };
+    using UnitStates = std::pmr::vector<UnitState>;
+    using UnitStatesView = container::TripleBuffer<UnitStates>::ReadHandle;
+
+    // The positions of a game's units as of a tick, in a flat list sorted
+    // by unit id. Taking a new snapshot reuses the storage of the old one.
+    class PositionSnapshot {
+      friend class Game;
+      struct Entry {
+        int id;
+        geometry::Location location;
+      };
+      std::vector<Entry> entries_;
+
+    public:
+      auto size() const -> std::size_t { return entries_.size(); }
+      auto empty() const -> bool { return entries_.empty(); }
+      // The unit's position, or nullptr if it was not in the game.
+      auto find(UnitRef) const -> geometry::Location const*;
+      void swap(PositionSnapshot& other) noexcept { entries_.swap(other.entries_); }
+    };
+
+    // A unit owned by a neighbouring game, as seen in this game's halo.
+    struct HaloUnit {
+      UnitRef ref;
+      geometry::Location location;
+    };
+    using Halo = std::pmr::vector<HaloUnit>;
+
+    // Damage dealt to a unit this game only sees in its halo.
+    struct ForeignDamage {
+      UnitRef target;
+      int amount;
+    };
+
+    // An attack by a local unit on a unit this game does not own.
+    struct ForeignTarget {
+      UnitRef attacker;
+      UnitRef target;
+    };
+
+    // A unit taken out of one game, to be attached to another one. It keeps
+    // its reference, properties and queued commands.
+    class DetachedUnit {
+      friend class Game;
+      UnitRef ref_;
+      memory::UniquePtr<Unit> unit_;
+      DetachedUnit(UnitRef, memory::UniquePtr<Unit>);
+
+    public:
+      DetachedUnit(DetachedUnit&&) noexcept;
+      auto operator=(DetachedUnit&&) noexcept -> DetachedUnit&;
+      ~DetachedUnit();
+
+      auto ref() const -> UnitRef { return ref_; }
+      auto location() const -> geometry::Location;
+    };
+
+    // Memory requested from the upstream resource, per subsystem.
+    struct AllocationStats {
+      memory::AllocationCounters units;
+      memory::AllocationCounters commands;
+      memory::AllocationCounters states;
+    };
+
   private:
-    using UnitPtr = std::unique_ptr<Unit>;
-    std::unordered_map<int, UnitPtr> units_;
+    memory::CountingResource units_memory_;
+    memory::CountingResource commands_memory_;
+    memory::CountingResource states_memory_;
+    std::pmr::unsynchronized_pool_resource unit_pool_{&units_memory_};
+    std::pmr::unsynchronized_pool_resource command_pool_{&commands_memory_};
+    bool forbid_allocations_{false};
+
+    using UnitPtr = memory::UniquePtr<Unit>;
+    std::pmr::unordered_map<int, UnitPtr> units_;
 
     geometry::Size const map_dimensions_{
       std::numeric_limits<float>::infinity(),
@@ -130,26 +273,171 @@ namespace game {
 
     GameEventsPtr listener_;
 
+    long long tick_{0};
+    int far_update_period_{1};
+    std::vector<geometry::Rectangle> interest_areas_;
+    auto within_interest(geometry::Location const&) const -> bool;
+
+    Halo halo_{&units_memory_};
+    auto find_in_halo(UnitRef) const -> HaloUnit const*;
+    std::pmr::vector<ForeignDamage> foreign_damage_{&units_memory_};
+    std::pmr::vector<ForeignTarget> foreign_targets_{&units_memory_};
+    bool keep_unseen_targets_{false};
+    void note_foreign_target(Unit const&);
+
+    container::TripleBuffer<UnitStates> published_states_{&states_memory_};
+    void publish_states();
+
+    void place_unit(UnitRef, geometry::Location, UnitProperties const&);
     void be_idle(Unit&);
-    void do_move(Unit&, commands::Move const&);
+    void finish_command(Unit&);
+    // Units are kept in one group per shape, next to their concrete shape,
+    // and each group is updated by code specialised for that shape. A group
+    // holds one list of the units simulated on every tick, followed by one
+    // bucket per time slice for the units outside every interest area that
+    // are not attacking (see simulate_far_units_every()). Only the bucket
+    // due is visited on a tick.
+    template<typename ShapeType>
+    struct ShapeGroupEntry {
+      Unit* unit;
+      ShapeType shape;
+    };
+    template<typename ShapeType>
+    using ShapeList = std::pmr::vector<ShapeGroupEntry<ShapeType>>;
+    template<typename ShapeType>
+    using ShapeGroup = std::pmr::vector<ShapeList<ShapeType>>;
+    template<typename> struct ShapeGroupsOf;
+    template<typename... ShapeTypes>
+    struct ShapeGroupsOf<std::variant<ShapeTypes...>> {
+      using type = std::tuple<ShapeGroup<ShapeTypes>...>;
+    };
+    typename ShapeGroupsOf<Shape>::type shape_groups_;
+    std::pmr::vector<Unit*> casualties_;
+    void add_to_shape_group(Unit&);
+    void remove_from_shape_group(Unit&);
+    void erase_casualties();
+
+    // Units whose list has to change are moved once the groups are no longer
+    // being walked.
+    bool walking_shape_groups_{false};
+    std::pmr::vector<Unit*> regroup_;
+    auto shape_list_for(Unit const&) const -> std::size_t;
+    auto shape_list_for(int id, bool outside_interest) const -> std::size_t;
+    void regroup(Unit&);
+    void apply_regroups();
+    void rebuild_shape_groups();
+
+    template<std::size_t... ShapeIndex>
+    void update_shape_groups(std::index_sequence<ShapeIndex...>);
+    template<typename ShapeType>
+    void update_shape_group(ShapeGroup<ShapeType>&);
+    template<typename ShapeType>
+    void update_shape_list(ShapeList<ShapeType> const&, bool far);
+    template<typename ShapeType>
+    void do_move(Unit&, ShapeType const&, commands::Move const&, int steps);
     void do_attack(Unit&, commands::Attack const&);
+    auto inflict_damage(Unit&, int) -> bool;
+
+    std::optional<InfluenceMap> influence_;
+    void check_influence_owner(UnitProperties const&) const;
+    void stamp_influence(Unit&);
+    void unstamp_influence(Unit&);
+
+    auto allocation_count() const -> std::size_t;
 
   public:
     Game();
     Game(float, float);
+    explicit Game(std::pmr::memory_resource* upstream);
+    Game(float, float, std::pmr::memory_resource* upstream);
     ~Game();
 
     auto spawn_unit_at(geometry::Location, UnitProperties const&) -> UnitRef;
+
+    // Create many units at once, writing their references to refs, in the
+    // order of the requests. Every request is checked before any unit is
+    // created: an out of bounds position throws InvalidPosition, an unknown
+    // kind std::out_of_range, and nothing is spawned.
+    void spawn_units(
+        std::span<UnitProperties const> kinds,
+        std::span<SpawnRequest const> requests,
+        std::span<UnitRef> refs
+    );
+    auto contains(UnitRef ref) const -> bool { return units_.count(ref.id) > 0; }
     auto position_of(UnitRef ref) const -> geometry::Location;
     auto unit(UnitRef ref) const -> UnitProperties;
     auto active_command_for(UnitRef ref) const -> Command;
 
+    // Replace whatever the unit is doing with a single command.
     void move(UnitRef, geometry::Location);
     void attack(UnitRef, UnitRef);
 
+    // Append a command to be carried out once the queued ones are finished.
+    void queue_move(UnitRef, geometry::Location);
+    void queue_attack(UnitRef, UnitRef);
+
     void update();
 
+    // Level of detail: moving units outside every interest area (what the
+    // players can see or are close to) are only simulated on every period-th
+    // tick, taking period steps at once. Their updates are staggered across
+    // ticks. Attacks are always resolved at full rate.
+    void simulate_far_units_every(int period);
+    void set_interest_areas(std::vector<geometry::Rectangle>);
+
+    // Maintain per-player influence grids (see InfluenceMap) alongside the
+    // simulation, for AI clients to query instead of scanning all units.
+    // Requires a map of finite dimensions. Units of players from max_players
+    // on are rejected with std::out_of_range, at this call and when they
+    // are spawned. The grids are allocated from the units' memory.
+    void track_influence(float cell_size, float max_radius, int max_players);
+    auto influence() const -> InfluenceMap const&;
+
+    void snapshot_positions(PositionSnapshot&) const;
+
+    // The unit states published at the end of the latest update(). Safe to
+    // call from any thread, concurrently with update(); the view stays valid
+    // and unchanged for as long as it is held.
+    auto unit_states() const -> UnitStatesView { return published_states_.read(); }
+
     void listen(GameEventsPtr l) { listener_ = l; }
+
+    // Support for splitting a world between several games, see World.
+    //
+    // The halo holds the positions of units owned by neighbouring games, so
+    // local units can chase and attack them. It is a flat list, which is
+    // refilled before every tick and keeps its storage; update() sorts it
+    // for lookups. Damage dealt to those units is not applied here but
+    // collected in foreign_damage(), for the owning game to apply() after
+    // the tick.
+    auto halo() -> Halo& { return halo_; }
+    auto foreign_damage() const -> std::pmr::vector<ForeignDamage> const& {
+      return foreign_damage_;
+    }
+    void clear_foreign_damage() { foreign_damage_.clear(); }
+    void apply_damage(UnitRef, int amount);
+
+    // Attacks on units owned elsewhere, noted when they are ordered or
+    // become active and on every tick they are carried out; the list is
+    // reset at the start of update(). Such a target may be further away
+    // than the halo reaches: with keep_attacks_on_unseen_targets(), the
+    // attacker then waits for it to be put into the halo, or for the attack
+    // to be dropped once the target is gone, instead of giving up on it.
+    auto foreign_targets() const -> std::pmr::vector<ForeignTarget> const& {
+      return foreign_targets_;
+    }
+    void keep_attacks_on_unseen_targets(bool value) { keep_unseen_targets_ = value; }
+    void drop_attack(UnitRef attacker, UnitRef target);
+
+    void append_positions_within(geometry::Rectangle const&, Halo&) const;
+    void detach_units_outside(geometry::Rectangle const&, std::vector<DetachedUnit>&);
+    void attach_unit(DetachedUnit&&);
+
+    auto allocation_stats() const -> AllocationStats;
+
+    // Debug aid: once the game has warmed up, have update() throw
+    // SteadyStateAllocation if it allocates memory from any subsystem.
+    void forbid_allocations_in_update(bool value) { forbid_allocations_ = value; }
   };
 
   inline auto operator ==(Game::UnitRef lhs, Game::UnitRef rhs) noexcept -> bool {
@@ -75,6 +75,16 @@ namespace geometry {
   }
 
 
+  inline auto Interpolated(
+      Location const& from, Location const& to, float t
+  ) noexcept -> Location {
+    return {
+      from.x + (to.x - from.x) * t,
+      from.y + (to.y - from.y) * t
+    };
+  }
+
+
   inline auto Normalized(Vector const& v) -> Vector {
     return v / LengthOf(v);
   }
@@ -115,11 +125,9 @@ namespace geometry {
   inline auto Contains(
       Rectangle const& rect, Location const& loc
   ) noexcept -> bool {
-    if (loc.x < rect.left || loc.x > rect.right)
-      return false;
-    if (loc.y < rect.top || loc.y > rect.bottom)
-      return false;
-    return true;
+    // Branch-free, so that it vectorises in loops; NaN is never contained.
+    return (loc.x >= rect.left) & (loc.x <= rect.right)
+        & (loc.y >= rect.top) & (loc.y <= rect.bottom);
   }
 
 
@@ -148,4 +156,14 @@ namespace geometry {
         rect.right - value, rect.bottom - value
     };
   }
+
+
+  inline auto ContractedBy(
+      Rectangle const& rect, Size const& half_extents
+  ) noexcept -> Rectangle {
+    return {
+        rect.left + half_extents.width, rect.top + half_extents.height,
+        rect.right - half_extents.width, rect.bottom - half_extents.height
+    };
+  }
 }
\ No newline at end of file
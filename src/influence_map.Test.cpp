@@ -0,0 +1,61 @@
+#include "influence_map.h"
+
+#include "geometry.h"
+
+#include <catch2/catch.hpp>
+
+#include <stdexcept>
+#include <limits>
+
+using namespace game;
+using geometry::Rectangle;
+using geometry::Size;
+
+
+TEST_CASE("An influence map spreads a unit's strength around its cell") {
+  auto map = InfluenceMap{Size{100, 100}, 10, 50, 2};
+  map.add(0, {55, 55}, 8, 20);
+
+  REQUIRE(map.at(0, {55, 55}) == Approx(8));
+  REQUIRE(map.at(0, {65, 55}) == Approx(4));
+  REQUIRE(map.at(0, {75, 55}) == Approx(0));
+  REQUIRE(map.at(1, {55, 55}) == 0);
+
+  SECTION("which can be summed over an area") {
+    REQUIRE(map.total_in(0, Rectangle{50, 50, 59, 69}) == Approx(12));
+  }
+
+  SECTION("and taken away again exactly") {
+    map.add(0, {52, 58}, 3, 30);
+    map.remove(0, {51, 51}, 3, 30);
+    map.remove(0, {59, 59}, 8, 20);
+    REQUIRE(map.total_in(0, Rectangle{0, 0, 100, 100}) == 0);
+  }
+}
+
+
+TEST_CASE("An influence map caps the radius of influence") {
+  auto map = InfluenceMap{Size{100, 100}, 10, 20, 1};
+  map.add(0, {5, 5}, 1, std::numeric_limits<float>::infinity());
+  REQUIRE(map.at(0, {15, 5}) == Approx(0.5));
+  REQUIRE(map.at(0, {45, 5}) == 0);
+}
+
+
+TEST_CASE("An influence map needs a finite map and positive cell size") {
+  auto const infinity = std::numeric_limits<float>::infinity();
+  REQUIRE_THROWS_AS((InfluenceMap{Size{infinity, 10}, 1, 10, 1}), std::invalid_argument);
+  REQUIRE_THROWS_AS((InfluenceMap{Size{10, infinity}, 1, 10, 1}), std::invalid_argument);
+  REQUIRE_THROWS_AS((InfluenceMap{Size{10, 10}, 0, 10, 1}), std::invalid_argument);
+  REQUIRE_THROWS_AS((InfluenceMap{Size{10, 10}, 1, infinity, 1}), std::invalid_argument);
+  REQUIRE_THROWS_AS((InfluenceMap{Size{1e30f, 10}, 1e-6f, 10, 1}), std::invalid_argument);
+}
+
+
+TEST_CASE("An influence map has a layer for each of a given number of players") {
+  auto map = InfluenceMap{Size{100, 100}, 10, 50, 2};
+  REQUIRE(map.max_players() == 2);
+  REQUIRE_THROWS_AS(map.add(2, {55, 55}, 8, 20), std::out_of_range);
+  REQUIRE_THROWS_AS(map.add(-1, {55, 55}, 8, 20), std::out_of_range);
+  REQUIRE_THROWS_AS((InfluenceMap{Size{100, 100}, 10, 50, 0}), std::invalid_argument);
+}
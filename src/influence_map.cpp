@@ -0,0 +1,136 @@
+#include "influence_map.h"
+
+#include "geometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+using namespace geometry;
+
+namespace game {
+  namespace {
+    constexpr auto FixedPointScale = 256.0f;
+  }
+
+
+  auto InfluenceMap::CellsAlong(float length, float cell_size) -> int {
+    if (!(cell_size > 0.0f) || !std::isfinite(length)) {
+      throw std::invalid_argument("Influence maps need a finite map and radius!");
+    }
+    auto const cells = std::ceil(std::max(length, 0.0f) / cell_size) + 1;
+    if (!(cells < static_cast<float>(std::numeric_limits<int>::max()))) {
+      throw std::invalid_argument("Influence map cells are too small for the map!");
+    }
+    return static_cast<int>(cells);
+  }
+
+
+  InfluenceMap::InfluenceMap(
+      Size map_dimensions, float cell_size, float max_radius, int max_players,
+      std::pmr::memory_resource* resource
+  )
+      : cell_size_{cell_size}
+      , max_radius_{max_radius}
+      , columns_{CellsAlong(map_dimensions.width, cell_size)}
+      , rows_{CellsAlong(map_dimensions.height, cell_size)}
+      , layers_{resource}
+  {
+    if (!std::isfinite(max_radius)) {
+      throw std::invalid_argument("Influence maps need a finite map and radius!");
+    }
+    if (max_players <= 0) {
+      throw std::invalid_argument("Influence maps need at least one player!");
+    }
+    layers_.resize(static_cast<std::size_t>(max_players));
+  }
+
+
+  auto InfluenceMap::cell_of(Location loc) const -> std::pair<int, int> {
+    return {
+      std::clamp(static_cast<int>(loc.x / cell_size_), 0, columns_ - 1),
+      std::clamp(static_cast<int>(loc.y / cell_size_), 0, rows_ - 1),
+    };
+  }
+
+
+  auto InfluenceMap::same_cell(Location lhs, Location rhs) const -> bool {
+    return cell_of(lhs) == cell_of(rhs);
+  }
+
+
+  void InfluenceMap::stamp(
+      int player, Location loc, float strength, float radius, int sign
+  ) {
+    radius = std::min(radius, max_radius_);
+    if (strength <= 0.0f || radius <= 0.0f) {
+      return;
+    }
+
+    if (player < 0 || player >= max_players()) {
+      throw std::out_of_range("No influence layer for player " + std::to_string(player));
+    }
+    auto& layer = layers_[player];
+    if (layer.empty()) {
+      layer.resize(static_cast<std::size_t>(columns_) * rows_);
+    }
+
+    auto const [column, row] = cell_of(loc);
+    auto const reach = static_cast<int>(radius / cell_size_);
+    for (auto r = std::max(row - reach, 0); r <= std::min(row + reach, rows_ - 1); ++r) {
+      for (auto c = std::max(column - reach, 0); c <= std::min(column + reach, columns_ - 1); ++c) {
+        auto const distance = cell_size_ * std::hypot(
+            static_cast<float>(c - column), static_cast<float>(r - row)
+        );
+        if (distance > radius) {
+          continue;
+        }
+        auto const value = strength * (1.0f - distance / radius);
+        layer[r * columns_ + c] += sign * static_cast<std::int32_t>(value * FixedPointScale);
+      }
+    }
+  }
+
+
+  void InfluenceMap::add(int player, Location loc, float strength, float radius) {
+    stamp(player, loc, strength, radius, 1);
+  }
+
+
+  void InfluenceMap::remove(int player, Location loc, float strength, float radius) {
+    stamp(player, loc, strength, radius, -1);
+  }
+
+
+  auto InfluenceMap::at(int player, Location loc) const -> float {
+    if (player < 0 || static_cast<std::size_t>(player) >= layers_.size()
+        || layers_[player].empty()) {
+      return 0.0f;
+    }
+    auto const [column, row] = cell_of(loc);
+    return layers_[player][row * columns_ + column] / FixedPointScale;
+  }
+
+
+  auto InfluenceMap::total_in(int player, Rectangle const& area) const -> float {
+    if (player < 0 || static_cast<std::size_t>(player) >= layers_.size()
+        || layers_[player].empty()) {
+      return 0.0f;
+    }
+
+    auto const& layer = layers_[player];
+    auto const [left, top] = cell_of({area.left, area.top});
+    auto const [right, bottom] = cell_of({area.right, area.bottom});
+    auto total = std::int64_t{0};
+    for (auto r = top; r <= bottom; ++r) {
+      for (auto c = left; c <= right; ++c) {
+        total += layer[r * columns_ + c];
+      }
+    }
+    return total / FixedPointScale;
+  }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "geometry.h"
+
+#include <cstdint>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+namespace game {
+  // Per-player grids of how much attack strength reaches each cell of the
+  // map. A unit contributes its strength at its own cell, falling off
+  // linearly to zero at its attack radius.
+  //
+  // Contributions are stamped from the centre of the unit's cell in fixed
+  // point, so taking one away again restores the grid exactly and units only
+  // need restamping when they change cells or strength.
+  class InfluenceMap {
+    static auto CellsAlong(float length, float cell_size) -> int;
+
+    float const cell_size_;
+    float const max_radius_;
+    int const columns_;
+    int const rows_;
+    std::pmr::vector<std::pmr::vector<std::int32_t>> layers_;
+
+    auto cell_of(geometry::Location) const -> std::pair<int, int>;
+    void stamp(int player, geometry::Location, float strength, float radius, int sign);
+
+  public:
+    // Radii are capped at max_radius, so that units without a practical
+    // attack range limit do not cover the whole map. Players are numbered
+    // from 0 to max_players - 1; a player's grid is allocated from the
+    // given resource when its first unit is added.
+    InfluenceMap(
+        geometry::Size map_dimensions, float cell_size, float max_radius, int max_players,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    );
+
+    auto cell_size() const -> float { return cell_size_; }
+    auto max_players() const -> int { return static_cast<int>(layers_.size()); }
+
+    // Whether two locations share a cell, and thus stamp the same way.
+    auto same_cell(geometry::Location, geometry::Location) const -> bool;
+
+    void add(int player, geometry::Location, float strength, float radius);
+    void remove(int player, geometry::Location, float strength, float radius);
+
+    auto at(int player, geometry::Location) const -> float;
+    auto total_in(int player, geometry::Rectangle const&) const -> float;
+  };
+}
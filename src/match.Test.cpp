@@ -4,6 +4,8 @@
 #include <catch2/catch.hpp>
 #include <trompeloeil.hpp>
 
+#include <sstream>
+
 
 namespace match {
   std::ostream& operator <<(std::ostream& lhs, Player const& rhs) {
@@ -91,4 +93,11 @@ TEST_CASE("when a match comes to a conclusion, all listeners will be notified")
   ;
 
   match.resign("X");
-}
\ No newline at end of file
+}
+
+TEST_CASE("A Match keeps its storage in the memory resource it was given") {
+  auto upstream = memory::CountingResource{};
+  auto match = Match{{"X", "Y"}, &upstream};
+  REQUIRE(match.allocation_stats().allocations > 0);
+  REQUIRE(upstream.counters().allocations == match.allocation_stats().allocations);
+}
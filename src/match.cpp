@@ -6,7 +6,10 @@
 
 
 namespace match {
-  Match::Match(std::initializer_list<std::string> l) {
+  Match::Match(
+      std::initializer_list<std::string> l,
+      std::pmr::memory_resource* upstream
+  ) : memory_{upstream} {
     for (auto&& player_name : l) {
       players_.emplace(player_name);
     }
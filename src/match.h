@@ -1,7 +1,10 @@
 #pragma once
 
+#include "memory.h"
+
 #include <initializer_list>
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <unordered_set>
 #include <vector>
@@ -32,21 +35,29 @@ namespace match {
   using EventsPtr = std::shared_ptr<struct Events>;
 
   class Match {
-    std::unordered_set<Player> players_;
-    std::vector<EventsPtr> listeners_;
+    memory::CountingResource memory_;
+    std::pmr::unordered_set<Player> players_{&memory_};
+    std::pmr::vector<EventsPtr> listeners_{&memory_};
 
   public:
-    Match(std::initializer_list<std::string> l);
+    Match(
+        std::initializer_list<std::string> l,
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource()
+    );
 
     auto finished() const -> bool;
     auto winner() const -> Player { return *players_.begin(); }
 
     void resign(std::string const& player_name);
 
-    using PlayerSet = std::unordered_set<Player>;
-    auto active_players() const -> PlayerSet { return players_; }
+    using PlayerSet = std::pmr::unordered_set<Player>;
+    auto active_players() const -> PlayerSet const& { return players_; }
 
     void listen(EventsPtr listener);
+
+    auto allocation_stats() const -> memory::AllocationCounters const& {
+      return memory_.counters();
+    }
   };
 
 
@@ -0,0 +1,125 @@
+#include "match_registry.h"
+
+#include <catch2/catch.hpp>
+#include <trompeloeil.hpp>
+
+#include <atomic>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace match;
+
+
+TEST_CASE("Player names are interned once") {
+  auto names = PlayerNames{};
+  auto const x = names.intern("X");
+  auto const y = names.intern("Y");
+  REQUIRE(x != y);
+  REQUIRE(names.intern("X") == x);
+  REQUIRE(names.name(y) == "Y");
+}
+
+
+TEST_CASE("A match registry hosts matches by their ID") {
+  auto names = PlayerNames{};
+  auto const x = names.intern("X");
+  auto const y = names.intern("Y");
+  auto const z = names.intern("Z");
+
+  auto registry = MatchRegistry{names, 4};
+  auto const first = registry.create({x, y, z});
+  auto const second = registry.create({x, y});
+  REQUIRE(registry.contains(first));
+  REQUIRE(registry.contains(second));
+  REQUIRE_FALSE(registry.finished(first));
+
+  SECTION("keeping track of the active players of each") {
+    registry.resign(first, y);
+    auto const active = registry.active_players(first);
+    REQUIRE(std::set<PlayerId>(active.begin(), active.end()) == std::set<PlayerId>{x, z});
+    REQUIRE(active.size() == 2);
+    REQUIRE(registry.active_players(second).size() == 2);
+  }
+
+  SECTION("finishing a match when all but one player resigned") {
+    REQUIRE_FALSE(registry.resign(first, x));
+    REQUIRE(registry.resign(first, z));
+    REQUIRE(registry.finished(first));
+    REQUIRE(registry.winner(first) == y);
+
+    SECTION("after which nobody can resign any more") {
+      REQUIRE_FALSE(registry.resign(first, y));
+      REQUIRE(registry.winner(first) == y);
+    }
+  }
+
+  SECTION("ignoring players not part of the match") {
+    REQUIRE_FALSE(registry.resign(second, z));
+    REQUIRE(registry.active_players(second).size() == 2);
+  }
+
+  SECTION("with every player taking part at most once") {
+    REQUIRE_THROWS_AS(registry.create({x, y, x}), std::invalid_argument);
+    REQUIRE_THROWS_AS(registry.create({}), std::invalid_argument);
+  }
+
+  SECTION("forgetting removed matches, even if their slot is reused") {
+    registry.remove(first);
+    REQUIRE_FALSE(registry.contains(first));
+    REQUIRE_THROWS_AS(registry.finished(first), UnknownMatch);
+
+    auto const reused = registry.create({x, y});
+    REQUIRE(registry.contains(reused));
+    REQUIRE_FALSE(registry.contains(first));
+  }
+}
+
+
+struct RegistryEventsMock : public Events {
+  MAKE_MOCK1(finished, void(std::string const&), override);
+};
+
+
+TEST_CASE("A match registry notifies listeners when a match is concluded") {
+  auto names = PlayerNames{};
+  auto const x = names.intern("X");
+  auto const y = names.intern("Y");
+  auto registry = MatchRegistry{names};
+  auto events = std::make_shared<RegistryEventsMock>();
+  registry.listen(events);
+
+  auto const match = registry.create({x, y});
+  REQUIRE_CALL(*events, finished(std::string{"Y"}));
+  registry.resign(match, x);
+}
+
+
+TEST_CASE("A match registry can be used from many threads") {
+  auto names = PlayerNames{};
+  auto registry = MatchRegistry{names, 8};
+  auto finished = std::atomic<int>{0};
+
+  auto threads = std::vector<std::thread>{};
+  for (auto t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      auto const a = names.intern("a" + std::to_string(t));
+      auto const b = names.intern("b" + std::to_string(t));
+      for (auto i = 0; i < 5000; ++i) {
+        auto const match = registry.create({a, b});
+        if (registry.resign(match, a) && registry.winner(match) == b) {
+          ++finished;
+        }
+        registry.remove(match);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  REQUIRE(finished == 20000);
+}
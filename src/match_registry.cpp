@@ -0,0 +1,247 @@
+#include "match_registry.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+
+namespace match {
+  auto PlayerNames::intern(std::string_view name) -> PlayerId {
+    {
+      auto lock = std::shared_lock{mutex_};
+      if (auto const it = ids_.find(name); it != ids_.end()) {
+        return it->second;
+      }
+    }
+
+    auto lock = std::unique_lock{mutex_};
+    if (auto const it = ids_.find(name); it != ids_.end()) {
+      return it->second;
+    }
+    auto const id = static_cast<PlayerId>(names_.size());
+    names_.emplace_back(name);
+    ids_.emplace(names_.back(), id);
+    return id;
+  }
+
+
+  auto PlayerNames::name(PlayerId id) const -> std::string const& {
+    auto lock = std::shared_lock{mutex_};
+    return names_.at(id);
+  }
+
+
+  namespace {
+    constexpr auto SlotBits = 24;
+    constexpr auto ShardBits = 8;
+
+    auto SlotOf(MatchId id) -> std::uint32_t {
+      return id.value & ((1u << SlotBits) - 1);
+    }
+
+    auto ShardOf(MatchId id) -> std::size_t {
+      return (id.value >> SlotBits) & ((1u << ShardBits) - 1);
+    }
+
+    auto GenerationOf(MatchId id) -> std::uint32_t {
+      return static_cast<std::uint32_t>(id.value >> (SlotBits + ShardBits));
+    }
+
+    auto MakeId(std::size_t shard, std::uint32_t slot, std::uint32_t generation) -> MatchId {
+      return MatchId{
+          std::uint64_t{generation} << (SlotBits + ShardBits)
+          | std::uint64_t{shard} << SlotBits
+          | slot
+      };
+    }
+
+    template<typename Mask>
+    auto CountOf(Mask mask) -> std::size_t {
+      return std::bitset<sizeof(Mask) * 8>{mask}.count();
+    }
+
+    template<typename Mask>
+    auto LowestIndexOf(Mask mask) -> std::size_t {
+      auto index = std::size_t{0};
+      for (; (mask & 1) == 0; mask >>= 1) {
+        ++index;
+      }
+      return index;
+    }
+  }
+
+
+  auto MatchRegistry::ActivePlayers::Iterator::operator*() const -> PlayerId {
+    return players_[LowestIndexOf(mask_)];
+  }
+
+
+  auto MatchRegistry::ActivePlayers::size() const -> std::size_t {
+    return CountOf(mask_);
+  }
+
+
+  MatchRegistry::MatchRegistry(PlayerNames const& names, std::size_t shard_count)
+      : names_{names}
+      , shards_(shard_count)
+  {
+    if (shard_count == 0 || shard_count > (1u << ShardBits)) {
+      throw std::invalid_argument("Unsupported number of registry shards!");
+    }
+  }
+
+
+  MatchRegistry::~MatchRegistry() = default;
+
+
+  auto MatchRegistry::find(MatchId id) const -> Record* {
+    auto const shard_index = ShardOf(id);
+    auto const slot = SlotOf(id);
+    if (shard_index >= shards_.size() || slot / ChunkSize >= MaxChunks) {
+      return nullptr;
+    }
+
+    auto* const chunk = shards_[shard_index].chunks[slot / ChunkSize].load(
+        std::memory_order_acquire
+    );
+    if (!chunk) {
+      return nullptr;
+    }
+
+    auto& entry = (*chunk)[slot % ChunkSize];
+    if (entry.generation.load(std::memory_order_acquire) != GenerationOf(id)) {
+      return nullptr;
+    }
+    return &entry;
+  }
+
+
+  auto MatchRegistry::record(MatchId id) const -> Record& {
+    if (auto* const entry = find(id)) {
+      return *entry;
+    }
+    throw UnknownMatch{};
+  }
+
+
+  auto MatchRegistry::create(std::initializer_list<PlayerId> players) -> MatchId {
+    return create(players.begin(), players.size());
+  }
+
+
+  auto MatchRegistry::create(PlayerId const* players, std::size_t count) -> MatchId {
+    if (count == 0 || count > MaxPlayers) {
+      throw std::invalid_argument("Unsupported number of players in a match!");
+    }
+    for (auto i = std::size_t{1}; i < count; ++i) {
+      if (std::find(players, players + i, players[i]) != players + i) {
+        throw std::invalid_argument("A player can only take part in a match once!");
+      }
+    }
+
+    auto const shard_index =
+        next_shard_.fetch_add(1, std::memory_order_relaxed) % shards_.size();
+    auto& shard = shards_[shard_index];
+    auto lock = std::lock_guard{shard.mutex};
+
+    auto slot = std::uint32_t{0};
+    if (!shard.free_slots.empty()) {
+      slot = shard.free_slots.back();
+      shard.free_slots.pop_back();
+    }
+    else {
+      if (shard.slot_count == ChunkSize * MaxChunks) {
+        throw std::runtime_error("Match registry shard is full!");
+      }
+      slot = shard.slot_count++;
+      if (slot % ChunkSize == 0) {
+        shard.owned_chunks.push_back(std::make_unique<Chunk>());
+        shard.free_slots.reserve(shard.owned_chunks.size() * ChunkSize);
+        shard.chunks[slot / ChunkSize].store(
+            shard.owned_chunks.back().get(), std::memory_order_release
+        );
+      }
+    }
+
+    auto& entry = (*shard.chunks[slot / ChunkSize].load())[slot % ChunkSize];
+    std::copy(players, players + count, entry.players.begin());
+    entry.player_count = count;
+    entry.active.store(
+        static_cast<PlayerMask>((std::uint64_t{1} << count) - 1),
+        std::memory_order_relaxed
+    );
+    auto const generation = entry.generation.load(std::memory_order_relaxed) + 1;
+    entry.generation.store(generation, std::memory_order_release);
+    return MakeId(shard_index, slot, generation);
+  }
+
+
+  void MatchRegistry::remove(MatchId id) {
+    auto& entry = record(id);
+    auto& shard = shards_[ShardOf(id)];
+    auto lock = std::lock_guard{shard.mutex};
+    auto expected = GenerationOf(id);
+    if (entry.generation.compare_exchange_strong(expected, expected + 1)) {
+      shard.free_slots.push_back(SlotOf(id));
+    }
+  }
+
+
+  auto MatchRegistry::contains(MatchId id) const -> bool {
+    return find(id) != nullptr;
+  }
+
+
+  auto MatchRegistry::finished(MatchId id) const -> bool {
+    return CountOf(record(id).active.load()) == 1;
+  }
+
+
+  auto MatchRegistry::winner(MatchId id) const -> PlayerId {
+    auto const& entry = record(id);
+    return entry.players[LowestIndexOf(entry.active.load())];
+  }
+
+
+  auto MatchRegistry::active_players(MatchId id) const -> ActivePlayers {
+    auto const& entry = record(id);
+    return ActivePlayers{entry.players.data(), entry.active.load()};
+  }
+
+
+  auto MatchRegistry::resign(MatchId id, PlayerId player) -> bool {
+    auto& entry = record(id);
+    auto index = std::size_t{0};
+    while (index < entry.player_count && entry.players[index] != player) {
+      ++index;
+    }
+    if (index == entry.player_count) {
+      return false;
+    }
+
+    // The last player standing cannot resign any more.
+    auto const bit = PlayerMask{1} << index;
+    auto before = entry.active.load();
+    do {
+      if ((before & bit) == 0 || CountOf(before) < 2) {
+        return false;
+      }
+    } while (!entry.active.compare_exchange_weak(before, before & ~bit));
+
+    if (CountOf(before) != 2) {
+      return false;
+    }
+
+    auto const& winner_name = names_.name(entry.players[LowestIndexOf(before & ~bit)]);
+    for (auto const& listener : listeners_) {
+      listener->finished(winner_name);
+    }
+    return true;
+  }
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "match.h"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+namespace match {
+  using PlayerId = std::uint32_t;
+
+  // Maps player names to small integer IDs, once per player, so that
+  // matches only ever handle the IDs. Safe to use from several threads.
+  class PlayerNames {
+    mutable std::shared_mutex mutex_;
+    std::deque<std::string> names_;
+    std::unordered_map<std::string_view, PlayerId> ids_;
+
+  public:
+    auto intern(std::string_view name) -> PlayerId;
+    auto name(PlayerId) const -> std::string const&;
+  };
+
+
+  class UnknownMatch : public std::runtime_error {
+  public:
+    UnknownMatch() : std::runtime_error("No such match in the registry!") {}
+  };
+
+
+  struct MatchId {
+    std::uint64_t value;
+  };
+
+  inline auto operator ==(MatchId lhs, MatchId rhs) noexcept -> bool {
+    return lhs.value == rhs.value;
+  }
+
+
+  // Hosts a large number of concurrently running matches.
+  //
+  // Matches are spread over shards, each growing in fixed-size chunks that
+  // never move, so finding a match by ID is plain indexing without locks.
+  // Only creating and removing matches takes the shard's lock. Resigning
+  // and querying are constant-time and do not allocate. Different threads
+  // may work on the same match, but a match must not be removed while it is
+  // still being used.
+  class MatchRegistry {
+  public:
+    static constexpr auto MaxPlayers = std::size_t{16};
+
+  private:
+    using PlayerMask = std::uint32_t;
+    static_assert(MaxPlayers <= sizeof(PlayerMask) * 8);
+
+    struct Record {
+      // Odd while the slot holds a live match.
+      std::atomic<std::uint32_t> generation{0};
+      std::atomic<PlayerMask> active{0};
+      std::size_t player_count{0};
+      std::array<PlayerId, MaxPlayers> players{};
+    };
+
+    static constexpr auto ChunkSize = std::size_t{4096};
+    static constexpr auto MaxChunks = std::size_t{1024};
+    using Chunk = std::array<Record, ChunkSize>;
+
+    struct alignas(64) Shard {
+      std::mutex mutex;
+      std::array<std::atomic<Chunk*>, MaxChunks> chunks{};
+      std::vector<std::unique_ptr<Chunk>> owned_chunks;
+      std::vector<std::uint32_t> free_slots;
+      std::uint32_t slot_count{0};
+    };
+
+    PlayerNames const& names_;
+    std::vector<Shard> shards_;
+    std::atomic<std::size_t> next_shard_{0};
+    std::vector<EventsPtr> listeners_;
+
+    auto find(MatchId) const -> Record*;
+    auto record(MatchId) const -> Record&;
+
+  public:
+    // A cheap, non-owning view of the players still active in a match.
+    class ActivePlayers {
+      PlayerId const* players_;
+      PlayerMask mask_;
+
+    public:
+      ActivePlayers(PlayerId const* players, PlayerMask mask)
+          : players_{players}, mask_{mask} {}
+
+      class Iterator {
+        PlayerId const* players_;
+        PlayerMask mask_;
+
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = PlayerId;
+        using difference_type = std::ptrdiff_t;
+        using pointer = PlayerId const*;
+        using reference = PlayerId;
+
+        Iterator(PlayerId const* players, PlayerMask mask)
+            : players_{players}, mask_{mask} {}
+
+        auto operator*() const -> PlayerId;
+        auto operator++() -> Iterator& {
+          mask_ &= mask_ - 1;
+          return *this;
+        }
+        auto operator++(int) -> Iterator {
+          auto previous = *this;
+          ++*this;
+          return previous;
+        }
+        auto operator==(Iterator const& rhs) const -> bool { return mask_ == rhs.mask_; }
+        auto operator!=(Iterator const& rhs) const -> bool { return mask_ != rhs.mask_; }
+      };
+
+      auto begin() const -> Iterator { return {players_, mask_}; }
+      auto end() const -> Iterator { return {players_, 0}; }
+      auto size() const -> std::size_t;
+    };
+
+    MatchRegistry(PlayerNames const& names, std::size_t shard_count = 64);
+    ~MatchRegistry();
+
+    // Throws std::invalid_argument for an unsupported number of players or
+    // a player listed twice.
+    auto create(std::initializer_list<PlayerId> players) -> MatchId;
+    auto create(PlayerId const* players, std::size_t count) -> MatchId;
+    void remove(MatchId);
+
+    auto contains(MatchId) const -> bool;
+    auto finished(MatchId) const -> bool;
+    auto winner(MatchId) const -> PlayerId;
+    auto active_players(MatchId) const -> ActivePlayers;
+
+    // Returns whether this resignation concluded the match, in which case
+    // the listeners have been notified.
+    auto resign(MatchId, PlayerId) -> bool;
+
+    // Listeners are meant to be registered before the registry is in use.
+    void listen(EventsPtr listener) { listeners_.push_back(listener); }
+  };
+}
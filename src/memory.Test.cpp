@@ -0,0 +1,39 @@
+#include "memory.h"
+
+#include <catch2/catch.hpp>
+
+#include <memory_resource>
+#include <vector>
+
+using namespace memory;
+
+
+TEST_CASE("A counting resource keeps track of what passes through it") {
+  auto resource = CountingResource{};
+  REQUIRE(resource.counters().allocations == 0);
+
+  auto* const p = resource.allocate(64, alignof(int));
+  REQUIRE(resource.counters().allocations == 1);
+  REQUIRE(resource.counters().bytes_in_use == 64);
+
+  resource.deallocate(p, 64, alignof(int));
+  REQUIRE(resource.counters().deallocations == 1);
+  REQUIRE(resource.counters().bytes_in_use == 0);
+
+  SECTION("including memory used by containers") {
+    auto values = std::pmr::vector<int>{&resource};
+    values.reserve(16);
+    REQUIRE(resource.counters().allocations == 2);
+  }
+}
+
+
+TEST_CASE("Objects can be owned by a unique pointer to resource memory") {
+  auto resource = CountingResource{};
+  {
+    auto const value = MakeUnique<std::vector<int>>(&resource, 3, 7);
+    REQUIRE(value->size() == 3);
+    REQUIRE(resource.counters().allocations == 1);
+  }
+  REQUIRE(resource.counters().deallocations == 1);
+}
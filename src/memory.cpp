@@ -0,0 +1,31 @@
+#include "memory.h"
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace memory {
+  auto CountingResource::do_allocate(
+      std::size_t bytes, std::size_t alignment
+  ) -> void* {
+    auto* const p = upstream_->allocate(bytes, alignment);
+    ++counters_.allocations;
+    counters_.bytes_in_use += bytes;
+    return p;
+  }
+
+
+  void CountingResource::do_deallocate(
+      void* p, std::size_t bytes, std::size_t alignment
+  ) {
+    upstream_->deallocate(p, bytes, alignment);
+    ++counters_.deallocations;
+    counters_.bytes_in_use -= bytes;
+  }
+
+
+  auto CountingResource::do_is_equal(
+      std::pmr::memory_resource const& other
+  ) const noexcept -> bool {
+    return this == &other;
+  }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+namespace memory {
+  struct AllocationCounters {
+    std::size_t allocations{0};
+    std::size_t deallocations{0};
+    std::size_t bytes_in_use{0};
+  };
+
+
+  // Forwards to an upstream resource and keeps count of what passes through,
+  // so every subsystem can be given its own and be accounted for separately.
+  class CountingResource : public std::pmr::memory_resource {
+    std::pmr::memory_resource* upstream_;
+    AllocationCounters counters_;
+
+    auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override;
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+    auto do_is_equal(
+        std::pmr::memory_resource const& other
+    ) const noexcept -> bool override;
+
+  public:
+    explicit CountingResource(
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource()
+    ) : upstream_{upstream} {}
+
+    auto counters() const noexcept -> AllocationCounters const& { return counters_; }
+  };
+
+
+  // unique_ptr that gives its object back to the resource it came from.
+  template<typename T>
+  struct ResourceDeleter {
+    std::pmr::memory_resource* resource;
+
+    void operator()(T* p) const {
+      p->~T();
+      resource->deallocate(p, sizeof(T), alignof(T));
+    }
+  };
+
+  template<typename T>
+  using UniquePtr = std::unique_ptr<T, ResourceDeleter<T>>;
+
+  template<typename T, typename... Args>
+  auto MakeUnique(std::pmr::memory_resource* resource, Args&&... args) -> UniquePtr<T> {
+    auto* const storage = resource->allocate(sizeof(T), alignof(T));
+    try {
+      auto* const object = ::new (storage) T(std::forward<Args>(args)...);
+      return UniquePtr<T>{object, ResourceDeleter<T>{resource}};
+    }
+    catch (...) {
+      resource->deallocate(storage, sizeof(T), alignof(T));
+      throw;
+    }
+  }
+}
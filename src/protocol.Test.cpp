@@ -0,0 +1,90 @@
+#include "protocol.h"
+
+#include <catch2/catch.hpp>
+
+#include <array>
+#include <cstdint>
+
+using namespace net;
+
+
+TEST_CASE("Messages survive a round trip through a datagram") {
+  auto buffer = std::array<std::uint8_t, MaxDatagramSize>{};
+
+  SECTION("a join names the game") {
+    auto const size = Encode(Join{3}, buffer.data(), buffer.size());
+    REQUIRE(TypeOf(buffer.data(), size) == MessageType::Join);
+
+    auto decoded = Join{};
+    REQUIRE(Decode(buffer.data(), size, decoded));
+    REQUIRE(decoded.game == 3);
+  }
+
+  SECTION("a command batch keeps every command") {
+    auto batch = CommandBatch{};
+    batch.game = 1;
+    batch.count = 2;
+    batch.commands[0] = {CommandKind::Move, 7, 10.0f, 20.0f, 0};
+    batch.commands[1] = {CommandKind::QueueAttack, 8, 0.0f, 0.0f, 9};
+    auto const size = Encode(batch, buffer.data(), buffer.size());
+
+    auto decoded = CommandBatch{};
+    REQUIRE(Decode(buffer.data(), size, decoded));
+    REQUIRE(decoded.game == 1);
+    REQUIRE(decoded.count == 2);
+    REQUIRE(decoded.commands[0].kind == CommandKind::Move);
+    REQUIRE(decoded.commands[0].x == 10.0f);
+    REQUIRE(decoded.commands[0].y == 20.0f);
+    REQUIRE(decoded.commands[1].unit == 8);
+    REQUIRE(decoded.commands[1].target == 9);
+  }
+
+  SECTION("a full state slice fits into a single datagram") {
+    auto state = State{};
+    state.game = 2;
+    state.tick = 40;
+    state.count = State::Capacity;
+    for (auto i = std::size_t{0}; i < State::Capacity; ++i) {
+      state.units[i] = {static_cast<std::int32_t>(i), 1, 1.5f, 2.5f, 100, 0};
+    }
+    auto const size = Encode(state, buffer.data(), buffer.size());
+    REQUIRE(size > 0);
+
+    auto decoded = State{};
+    REQUIRE(Decode(buffer.data(), size, decoded));
+    REQUIRE(decoded.tick == 40);
+    REQUIRE(decoded.count == State::Capacity);
+    REQUIRE(decoded.units[63].id == 63);
+    REQUIRE(decoded.units[63].owner == 1);
+    REQUIRE(decoded.units[63].x == 1.5f);
+  }
+}
+
+
+TEST_CASE("Malformed datagrams are rejected") {
+  auto buffer = std::array<std::uint8_t, MaxDatagramSize>{};
+  auto batch = CommandBatch{};
+  batch.count = 4;
+  auto const size = Encode(batch, buffer.data(), buffer.size());
+
+  SECTION("when they are truncated") {
+    auto decoded = CommandBatch{};
+    REQUIRE_FALSE(Decode(buffer.data(), size - 1, decoded));
+  }
+
+  SECTION("when they claim more entries than fit") {
+    buffer[2 + 1 + 4] = CommandBatch::Capacity + 1;
+    auto decoded = CommandBatch{};
+    REQUIRE_FALSE(Decode(buffer.data(), size, decoded));
+  }
+
+  SECTION("when they do not carry the protocol magic") {
+    buffer[0] ^= 0xff;
+    REQUIRE_FALSE(TypeOf(buffer.data(), size).has_value());
+  }
+
+  SECTION("when they are of another type") {
+    auto decoded = Join{};
+    REQUIRE_FALSE(Decode(buffer.data(), size, decoded));
+  }
+}
@@ -0,0 +1,145 @@
+#include "protocol.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+namespace net {
+  namespace {
+    auto Header(Writer& writer, MessageType type) -> Writer& {
+      return writer.put(ProtocolMagic).put(type);
+    }
+
+    auto Header(Reader& reader, MessageType expected) -> bool {
+      auto magic = std::uint16_t{};
+      auto type = MessageType{};
+      return reader.get(magic) && reader.get(type)
+          && magic == ProtocolMagic && type == expected;
+    }
+  }
+
+
+  auto TypeOf(std::uint8_t const* data, std::size_t size) -> std::optional<MessageType> {
+    auto reader = Reader{data, size};
+    auto magic = std::uint16_t{};
+    auto type = std::uint8_t{};
+    if (!reader.get(magic) || !reader.get(type) || magic != ProtocolMagic) {
+      return std::nullopt;
+    }
+    if (type < static_cast<std::uint8_t>(MessageType::Join)
+        || type > static_cast<std::uint8_t>(MessageType::State)) {
+      return std::nullopt;
+    }
+    return static_cast<MessageType>(type);
+  }
+
+
+  auto Encode(Join const& join, std::uint8_t* out, std::size_t capacity) -> std::size_t {
+    auto writer = Writer{out, capacity};
+    Header(writer, MessageType::Join).put(join.game);
+    return writer.size();
+  }
+
+
+  auto Decode(std::uint8_t const* data, std::size_t size, Join& join) -> bool {
+    auto reader = Reader{data, size};
+    return Header(reader, MessageType::Join) && reader.get(join.game);
+  }
+
+
+  auto Encode(Welcome const& welcome, std::uint8_t* out, std::size_t capacity) -> std::size_t {
+    auto writer = Writer{out, capacity};
+    Header(writer, MessageType::Welcome).put(welcome.game).put(welcome.player);
+    return writer.size();
+  }
+
+
+  auto Decode(std::uint8_t const* data, std::size_t size, Welcome& welcome) -> bool {
+    auto reader = Reader{data, size};
+    return Header(reader, MessageType::Welcome)
+        && reader.get(welcome.game)
+        && reader.get(welcome.player);
+  }
+
+
+  auto Encode(CommandBatch const& batch, std::uint8_t* out, std::size_t capacity) -> std::size_t {
+    auto writer = Writer{out, capacity};
+    Header(writer, MessageType::Commands).put(batch.game).put(batch.count);
+    for (auto i = 0; i < batch.count; ++i) {
+      auto const& command = batch.commands[i];
+      writer.put(command.kind)
+          .put(command.unit)
+          .put(command.x)
+          .put(command.y)
+          .put(command.target);
+    }
+    return writer.size();
+  }
+
+
+  auto Decode(std::uint8_t const* data, std::size_t size, CommandBatch& batch) -> bool {
+    auto reader = Reader{data, size};
+    if (!Header(reader, MessageType::Commands)
+        || !reader.get(batch.game)
+        || !reader.get(batch.count)
+        || batch.count > CommandBatch::Capacity) {
+      return false;
+    }
+
+    for (auto i = 0; i < batch.count; ++i) {
+      auto& command = batch.commands[i];
+      if (!reader.get(command.kind)
+          || !reader.get(command.unit)
+          || !reader.get(command.x)
+          || !reader.get(command.y)
+          || !reader.get(command.target)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+
+  auto Encode(State const& state, std::uint8_t* out, std::size_t capacity) -> std::size_t {
+    auto writer = Writer{out, capacity};
+    Header(writer, MessageType::State)
+        .put(state.game)
+        .put(state.tick)
+        .put(state.count);
+    for (auto i = 0; i < state.count; ++i) {
+      auto const& unit = state.units[i];
+      writer.put(unit.id)
+          .put(unit.owner)
+          .put(unit.x)
+          .put(unit.y)
+          .put(unit.hit_points)
+          .put(unit.command);
+    }
+    return writer.size();
+  }
+
+
+  auto Decode(std::uint8_t const* data, std::size_t size, State& state) -> bool {
+    auto reader = Reader{data, size};
+    if (!Header(reader, MessageType::State)
+        || !reader.get(state.game)
+        || !reader.get(state.tick)
+        || !reader.get(state.count)
+        || state.count > State::Capacity) {
+      return false;
+    }
+
+    for (auto i = 0; i < state.count; ++i) {
+      auto& unit = state.units[i];
+      if (!reader.get(unit.id)
+          || !reader.get(unit.owner)
+          || !reader.get(unit.x)
+          || !reader.get(unit.y)
+          || !reader.get(unit.hit_points)
+          || !reader.get(unit.command)) {
+        return false;
+      }
+    }
+    return true;
+  }
+}
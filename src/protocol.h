@@ -0,0 +1,138 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+
+// Datagram format spoken between the game server and its clients. Every
+// message fits into a single UDP datagram and is decoded into fixed-size
+// structures, without allocating. Values are in host byte order, which is
+// fine for the little-endian hosts the server runs on.
+namespace net {
+  constexpr auto MaxDatagramSize = std::size_t{1400};
+  constexpr auto ProtocolMagic = std::uint16_t{0x5152};
+
+  enum class MessageType : std::uint8_t {
+    Join = 1,
+    Welcome = 2,
+    Commands = 3,
+    State = 4,
+  };
+
+
+  enum class CommandKind : std::uint8_t {
+    Move = 1,
+    Attack = 2,
+    QueueMove = 3,
+    QueueAttack = 4,
+  };
+
+  struct Command {
+    CommandKind kind;
+    std::int32_t unit;
+    float x;
+    float y;
+    std::int32_t target;
+  };
+
+
+  struct UnitSnapshot {
+    std::int32_t id;
+    std::uint8_t owner;
+    float x;
+    float y;
+    std::int32_t hit_points;
+    std::uint8_t command;
+  };
+
+
+  // Client asks to take part in a game.
+  struct Join {
+    std::uint32_t game;
+  };
+
+  // Server tells a client which player it is.
+  struct Welcome {
+    std::uint32_t game;
+    std::uint8_t player;
+  };
+
+  struct CommandBatch {
+    static constexpr auto Capacity = std::size_t{64};
+    std::uint32_t game;
+    std::uint8_t count;
+    std::array<Command, Capacity> commands;
+  };
+
+  // One slice of a game's units as of a tick; larger games are sent as
+  // several datagrams.
+  struct State {
+    static constexpr auto Capacity = std::size_t{64};
+    std::uint32_t game;
+    std::uint32_t tick;
+    std::uint16_t count;
+    std::array<UnitSnapshot, Capacity> units;
+  };
+
+
+  class Writer {
+    std::uint8_t* data_;
+    std::size_t capacity_;
+    std::size_t size_{0};
+
+  public:
+    Writer(std::uint8_t* data, std::size_t capacity)
+        : data_{data}, capacity_{capacity} {}
+
+    template<typename T>
+    auto put(T value) -> Writer& {
+      static_assert(std::is_trivially_copyable_v<T>);
+      if (size_ + sizeof(T) <= capacity_) {
+        std::memcpy(data_ + size_, &value, sizeof(T));
+      }
+      size_ += sizeof(T);
+      return *this;
+    }
+
+    // Bytes written, or zero if the message did not fit.
+    auto size() const -> std::size_t { return size_ <= capacity_ ? size_ : 0; }
+  };
+
+
+  class Reader {
+    std::uint8_t const* data_;
+    std::size_t size_;
+    std::size_t position_{0};
+
+  public:
+    Reader(std::uint8_t const* data, std::size_t size)
+        : data_{data}, size_{size} {}
+
+    template<typename T>
+    auto get(T& value) -> bool {
+      static_assert(std::is_trivially_copyable_v<T>);
+      if (position_ + sizeof(T) > size_) {
+        return false;
+      }
+      std::memcpy(&value, data_ + position_, sizeof(T));
+      position_ += sizeof(T);
+      return true;
+    }
+  };
+
+
+  auto TypeOf(std::uint8_t const* data, std::size_t size) -> std::optional<MessageType>;
+
+  auto Encode(Join const&, std::uint8_t* out, std::size_t capacity) -> std::size_t;
+  auto Encode(Welcome const&, std::uint8_t* out, std::size_t capacity) -> std::size_t;
+  auto Encode(CommandBatch const&, std::uint8_t* out, std::size_t capacity) -> std::size_t;
+  auto Encode(State const&, std::uint8_t* out, std::size_t capacity) -> std::size_t;
+
+  auto Decode(std::uint8_t const* data, std::size_t size, Join&) -> bool;
+  auto Decode(std::uint8_t const* data, std::size_t size, Welcome&) -> bool;
+  auto Decode(std::uint8_t const* data, std::size_t size, CommandBatch&) -> bool;
+  auto Decode(std::uint8_t const* data, std::size_t size, State&) -> bool;
+}
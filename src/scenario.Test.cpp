@@ -0,0 +1,118 @@
+#include "scenario.h"
+
+#include "game.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <sstream>
+#include <variant>
+#include <vector>
+
+using game::Game;
+using geometry::Location;
+
+
+TEST_CASE("Scenarios are compiled from text") {
+  auto text = std::istringstream{R"(
+    # Two small armies
+    map 200 100
+    kind soldier hit_points=40 attack_radius=5 attack_damage=6 owner=0
+    kind tank hit_points=300 velocity=0.5 owner=1 shape=aabb:3:2
+
+    unit soldier 10 20
+    grid tank 100 10 3 2 10
+  )"};
+  auto const compiled = scenario::Compile(text);
+
+  REQUIRE(compiled.map_size.width == 200);
+  REQUIRE(compiled.map_size.height == 100);
+  REQUIRE(compiled.kinds.size() == 2);
+  REQUIRE(compiled.kinds[1].hit_points() == 300);
+  REQUIRE(std::holds_alternative<game::UnitShape::AABB>(compiled.kinds[1].shape()));
+  REQUIRE(compiled.units.size() == 7);
+  REQUIRE(compiled.units[0].location == Location{10, 20});
+  REQUIRE(compiled.units[0].kind == 0);
+  REQUIRE(compiled.units[6].location == Location{120, 20});
+  REQUIRE(compiled.units[6].kind == 1);
+
+  SECTION("and survive the round trip through the binary form") {
+    auto binary = std::stringstream{};
+    scenario::Write(binary, compiled);
+    auto const loaded = scenario::Read(binary);
+
+    REQUIRE(loaded.map_size.width == 200);
+    REQUIRE(loaded.kinds.size() == 2);
+    REQUIRE(loaded.kinds[0].attack_radius() == 5);
+    REQUIRE(loaded.kinds[1].velocity() == 0.5f);
+    REQUIRE(loaded.kinds[1].owner() == 1);
+    REQUIRE(loaded.units.size() == 7);
+    REQUIRE(loaded.units[6].location == Location{120, 20});
+
+    SECTION("to populate a game") {
+      auto game = Game{loaded.map_size.width, loaded.map_size.height};
+      auto refs = std::vector<Game::UnitRef>(loaded.units.size());
+      scenario::Spawn(game, loaded, refs);
+
+      REQUIRE(game.position_of(refs[4]) == Location{100, 20});
+      REQUIRE(game.unit(refs[4]).hit_points() == 300);
+    }
+  }
+}
+
+
+TEST_CASE("Invalid scenarios are rejected") {
+  SECTION("when they refer to unknown kinds") {
+    auto text = std::istringstream{"unit ghost 1 1"};
+    REQUIRE_THROWS_AS(scenario::Compile(text), scenario::InvalidScenario);
+  }
+
+  SECTION("when they give a kind a negative owner") {
+    auto text = std::istringstream{"kind rebel owner=-1"};
+    REQUIRE_THROWS_AS(scenario::Compile(text), scenario::InvalidScenario);
+  }
+
+  SECTION("when a compiled kind has a negative owner") {
+    auto text = std::istringstream{"kind soldier\nunit soldier 1 1"};
+    auto binary = std::stringstream{};
+    scenario::Write(binary, scenario::Compile(text));
+    auto compiled = binary.str();
+
+    auto const owner = std::int32_t{-1};
+    auto const offset = 24 + 5 * 4; // header, then the fields before the owner
+    compiled.replace(offset, sizeof(owner), reinterpret_cast<char const*>(&owner), sizeof(owner));
+    auto corrupt = std::istringstream{compiled};
+    REQUIRE_THROWS_AS(scenario::Read(corrupt), scenario::InvalidScenario);
+  }
+
+  SECTION("when they place units outside of the map") {
+    auto text = std::istringstream{"map 10 10\nkind soldier\nunit soldier 20 5"};
+    REQUIRE_THROWS_AS(scenario::Compile(text), scenario::InvalidScenario);
+  }
+
+  SECTION("when the compiled form is truncated") {
+    auto text = std::istringstream{"kind soldier\nunit soldier 1 1\nunit soldier 2 2"};
+    auto binary = std::stringstream{};
+    scenario::Write(binary, scenario::Compile(text));
+    auto truncated = std::istringstream{binary.str().substr(0, binary.str().size() - 1)};
+    REQUIRE_THROWS_AS(scenario::Read(truncated), scenario::InvalidScenario);
+  }
+
+  SECTION("when the header claims more records than the file holds") {
+    auto text = std::istringstream{"kind soldier\nunit soldier 1 1"};
+    auto binary = std::stringstream{};
+    scenario::Write(binary, scenario::Compile(text));
+    auto header = binary.str();
+
+    auto const huge = std::uint32_t{2'000'000'000};
+    auto const offset = GENERATE(16, 20); // kind count, unit count
+    header.replace(offset, sizeof(huge), reinterpret_cast<char const*>(&huge), sizeof(huge));
+    auto corrupt = std::istringstream{header};
+    REQUIRE_THROWS_AS(scenario::Read(corrupt), scenario::InvalidScenario);
+  }
+
+  SECTION("when the file is not a compiled scenario") {
+    auto garbage = std::istringstream{"map 10 10\n"};
+    REQUIRE_THROWS_AS(scenario::Read(garbage), scenario::InvalidScenario);
+  }
+}
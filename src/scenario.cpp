@@ -0,0 +1,364 @@
+#include "scenario.h"
+
+#include "variant.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+
+using game::SpawnRequest;
+using game::UnitProperties;
+namespace UnitShape = game::UnitShape;
+
+namespace scenario {
+  namespace {
+    constexpr auto Magic = std::uint32_t{0x4e435351}; // "QSCN"
+    constexpr auto Version = std::uint32_t{1};
+
+    // Records read from the binary form per allocation.
+    constexpr auto ReadChunk = std::uint32_t{1} << 16;
+
+    static_assert(std::is_trivially_copyable_v<SpawnRequest>);
+    static_assert(sizeof(SpawnRequest) == 12, "SpawnRequest is part of the file format");
+
+    // Unit kinds as stored in the binary form.
+    struct KindRecord {
+      std::int32_t hit_points;
+      float attack_radius;
+      std::int32_t attack_damage;
+      float velocity;
+      float acceleration;
+      std::int32_t owner;
+      std::uint32_t shape;
+      float shape_parameters[2];
+    };
+
+
+    template<typename T>
+    void Put(std::ostream& out, T const& value) {
+      out.write(reinterpret_cast<char const*>(&value), sizeof(T));
+    }
+
+    template<typename T>
+    void Get(std::istream& in, T& value) {
+      if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+        throw InvalidScenario("truncated file");
+      }
+    }
+
+
+    auto RecordOf(UnitProperties const& props) -> KindRecord {
+      auto record = KindRecord{
+        props.hit_points(),
+        props.attack_radius(),
+        static_cast<std::int32_t>(props.attack_damage()),
+        props.velocity(),
+        props.acceleration(),
+        props.owner(),
+        static_cast<std::uint32_t>(props.shape().index()),
+        {0.0f, 0.0f},
+      };
+      variant::Match(props.shape(),
+          [&record](UnitShape::Circle const& c) {
+            record.shape_parameters[0] = c.radius;
+          },
+          [&record](UnitShape::AABB const& b) {
+            record.shape_parameters[0] = b.half_width;
+            record.shape_parameters[1] = b.half_height;
+          },
+          [&record](UnitShape::Capsule const& c) {
+            record.shape_parameters[0] = c.radius;
+            record.shape_parameters[1] = c.half_length;
+          }
+      );
+      return record;
+    }
+
+
+    auto ShapeOf(std::uint32_t index, float a, float b) -> game::Shape {
+      switch (index) {
+        case 0: return UnitShape::Circle{a};
+        case 1: return UnitShape::AABB{a, b};
+        case 2: return UnitShape::Capsule{a, b};
+        default: throw InvalidScenario("unknown unit shape");
+      }
+    }
+
+
+    auto PropertiesOf(KindRecord const& record) -> UnitProperties {
+      if (record.owner < 0) {
+        throw InvalidScenario("negative owner");
+      }
+      return UnitProperties::Make()
+          .hit_points(record.hit_points)
+          .attack_radius(record.attack_radius)
+          .attack_damage(record.attack_damage)
+          .velocity(record.velocity)
+          .acceleration(record.acceleration)
+          .owner(record.owner)
+          .shape(ShapeOf(record.shape, record.shape_parameters[0], record.shape_parameters[1]));
+    }
+
+
+    // Text form parsing.
+    class Parser {
+      Scenario scenario_;
+      std::unordered_map<std::string, std::uint32_t> kind_names_;
+      int line_number_{0};
+
+      [[noreturn]] void fail(std::string const& what) const {
+        throw InvalidScenario("line " + std::to_string(line_number_) + ": " + what);
+      }
+
+      template<typename T>
+      auto read(std::istream& in, char const* what) -> T {
+        auto value = T{};
+        if (!(in >> value)) {
+          fail(std::string{"expected "} + what);
+        }
+        return value;
+      }
+
+      auto parse_float(std::string const& text) const -> float {
+        try {
+          auto consumed = std::size_t{0};
+          auto const value = std::stof(text, &consumed);
+          if (consumed == text.size()) {
+            return value;
+          }
+        }
+        catch (std::exception const&) {}
+        fail("not a number: " + text);
+      }
+
+      auto parse_shape(std::string const& text) const -> game::Shape {
+        auto parts = std::vector<std::string>{};
+        auto stream = std::istringstream{text};
+        for (auto part = std::string{}; std::getline(stream, part, ':');) {
+          parts.push_back(part);
+        }
+
+        if (parts.size() == 2 && parts[0] == "circle") {
+          return UnitShape::Circle{parse_float(parts[1])};
+        }
+        if (parts.size() == 3 && parts[0] == "aabb") {
+          return UnitShape::AABB{parse_float(parts[1]), parse_float(parts[2])};
+        }
+        if (parts.size() == 3 && parts[0] == "capsule") {
+          return UnitShape::Capsule{parse_float(parts[1]), parse_float(parts[2])};
+        }
+        fail("invalid shape: " + text);
+      }
+
+      void parse_kind(std::istream& in) {
+        auto const name = read<std::string>(in, "kind name");
+        if (kind_names_.count(name) > 0) {
+          fail("kind defined twice: " + name);
+        }
+
+        auto builder = UnitProperties::Make();
+        for (auto property = std::string{}; in >> property;) {
+          auto const separator = property.find('=');
+          if (separator == std::string::npos) {
+            fail("expected property=value, got " + property);
+          }
+          auto const key = property.substr(0, separator);
+          auto const value = property.substr(separator + 1);
+
+          if (key == "hit_points") {
+            builder.hit_points(static_cast<int>(parse_float(value)));
+          }
+          else if (key == "attack_radius") {
+            builder.attack_radius(parse_float(value));
+          }
+          else if (key == "attack_damage") {
+            builder.attack_damage(static_cast<int>(parse_float(value)));
+          }
+          else if (key == "velocity") {
+            builder.velocity(parse_float(value));
+          }
+          else if (key == "acceleration") {
+            builder.acceleration(parse_float(value));
+          }
+          else if (key == "owner") {
+            auto const owner = static_cast<int>(parse_float(value));
+            if (owner < 0) {
+              fail("negative owner: " + value);
+            }
+            builder.owner(owner);
+          }
+          else if (key == "shape") {
+            builder.shape(parse_shape(value));
+          }
+          else {
+            fail("unknown property: " + key);
+          }
+        }
+
+        UnitProperties const props = builder;
+        kind_names_.emplace(name, static_cast<std::uint32_t>(scenario_.kinds.size()));
+        scenario_.kinds.push_back(props);
+      }
+
+      auto kind_of(std::istream& in) -> std::uint32_t {
+        auto const name = read<std::string>(in, "kind name");
+        auto const kind = kind_names_.find(name);
+        if (kind == kind_names_.end()) {
+          fail("unknown kind: " + name);
+        }
+        return kind->second;
+      }
+
+      void add_unit(std::uint32_t kind, geometry::Location location) {
+        auto const& map = scenario_.map_size;
+        if (!Contains(geometry::Rectangle{map}, location)) {
+          fail("unit outside of the map");
+        }
+        scenario_.units.push_back({location, kind});
+      }
+
+      void parse_unit(std::istream& in) {
+        auto const kind = kind_of(in);
+        auto const x = read<float>(in, "x");
+        auto const y = read<float>(in, "y");
+        add_unit(kind, {x, y});
+      }
+
+      void parse_grid(std::istream& in) {
+        auto const kind = kind_of(in);
+        auto const x = read<float>(in, "x");
+        auto const y = read<float>(in, "y");
+        auto const columns = read<int>(in, "columns");
+        auto const rows = read<int>(in, "rows");
+        auto const spacing = read<float>(in, "spacing");
+        if (columns < 0 || rows < 0) {
+          fail("negative grid size");
+        }
+
+        scenario_.units.reserve(
+            scenario_.units.size() + static_cast<std::size_t>(columns) * rows
+        );
+        for (auto row = 0; row < rows; ++row) {
+          for (auto column = 0; column < columns; ++column) {
+            add_unit(kind, {x + column * spacing, y + row * spacing});
+          }
+        }
+      }
+
+    public:
+      auto parse(std::istream& text) -> Scenario {
+        for (auto line = std::string{}; std::getline(text, line);) {
+          ++line_number_;
+          line = line.substr(0, line.find('#'));
+
+          auto in = std::istringstream{line};
+          auto keyword = std::string{};
+          if (!(in >> keyword)) {
+            continue;
+          }
+
+          if (keyword == "map") {
+            if (!scenario_.units.empty()) {
+              fail("the map must be given before the units");
+            }
+            auto const width = read<float>(in, "width");
+            auto const height = read<float>(in, "height");
+            scenario_.map_size = {width, height};
+          }
+          else if (keyword == "kind") {
+            parse_kind(in);
+          }
+          else if (keyword == "unit") {
+            parse_unit(in);
+          }
+          else if (keyword == "grid") {
+            parse_grid(in);
+          }
+          else {
+            fail("unknown keyword: " + keyword);
+          }
+        }
+        return std::move(scenario_);
+      }
+    };
+  }
+
+
+  auto Compile(std::istream& text) -> Scenario {
+    return Parser{}.parse(text);
+  }
+
+
+  void Write(std::ostream& binary, Scenario const& scenario) {
+    Put(binary, Magic);
+    Put(binary, Version);
+    Put(binary, scenario.map_size.width);
+    Put(binary, scenario.map_size.height);
+    Put(binary, static_cast<std::uint32_t>(scenario.kinds.size()));
+    Put(binary, static_cast<std::uint32_t>(scenario.units.size()));
+    for (auto const& kind : scenario.kinds) {
+      Put(binary, RecordOf(kind));
+    }
+    binary.write(
+        reinterpret_cast<char const*>(scenario.units.data()),
+        static_cast<std::streamsize>(scenario.units.size() * sizeof(SpawnRequest))
+    );
+  }
+
+
+  auto Read(std::istream& binary) -> Scenario {
+    auto magic = std::uint32_t{};
+    auto version = std::uint32_t{};
+    Get(binary, magic);
+    Get(binary, version);
+    if (magic != Magic) {
+      throw InvalidScenario("not a compiled scenario");
+    }
+    if (version != Version) {
+      throw InvalidScenario("unsupported version " + std::to_string(version));
+    }
+
+    auto scenario = Scenario{};
+    Get(binary, scenario.map_size.width);
+    Get(binary, scenario.map_size.height);
+
+    auto kind_count = std::uint32_t{};
+    auto unit_count = std::uint32_t{};
+    Get(binary, kind_count);
+    Get(binary, unit_count);
+    if (unit_count > static_cast<std::uint32_t>(std::numeric_limits<int>::max())) {
+      throw InvalidScenario("too many units");
+    }
+
+    // The counts are not trusted with an allocation before the records
+    // behind them are read: a corrupt header only costs a chunk.
+    scenario.kinds.reserve(std::min(kind_count, ReadChunk));
+    for (auto i = std::uint32_t{0}; i < kind_count; ++i) {
+      auto record = KindRecord{};
+      Get(binary, record);
+      scenario.kinds.push_back(PropertiesOf(record));
+    }
+
+    while (scenario.units.size() < unit_count) {
+      auto const read = scenario.units.size();
+      auto const count = std::min<std::size_t>(unit_count - read, ReadChunk);
+      scenario.units.resize(read + count);
+      auto const size = static_cast<std::streamsize>(count * sizeof(SpawnRequest));
+      if (!binary.read(reinterpret_cast<char*>(scenario.units.data() + read), size)) {
+        throw InvalidScenario("truncated file");
+      }
+    }
+    return scenario;
+  }
+
+
+  void Spawn(game::Game& game, Scenario const& scenario, std::span<game::Game::UnitRef> refs) {
+    game.spawn_units(scenario.kinds, scenario.units, refs);
+  }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "game.h"
+#include "geometry.h"
+
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Scenarios describe the units a game starts with.
+//
+// They are written as text and compiled offline (`QuaRTS compile-scenario`)
+// into a binary form. The unit table of the binary form has the layout of
+// game::SpawnRequest, so loading it is a single read into the buffer handed
+// to Game::spawn_units().
+//
+// The text form is line based, with # starting a comment:
+//
+//   map <width> <height>
+//   kind <name> [hit_points=<n>] [attack_radius=<r>] [attack_damage=<n>]
+//        [velocity=<v>] [acceleration=<a>] [owner=<player>]
+//        [shape=circle:<r> | shape=aabb:<w>:<h> | shape=capsule:<r>:<l>]
+//   unit <kind> <x> <y>
+//   grid <kind> <x> <y> <columns> <rows> <spacing>
+namespace scenario {
+  class InvalidScenario : public std::runtime_error {
+  public:
+    explicit InvalidScenario(std::string const& what)
+        : std::runtime_error("Invalid scenario: " + what) {}
+  };
+
+
+  struct Scenario {
+    geometry::Size map_size{
+      std::numeric_limits<float>::infinity(),
+      std::numeric_limits<float>::infinity(),
+    };
+    std::vector<game::UnitProperties> kinds;
+    std::vector<game::SpawnRequest> units;
+  };
+
+  auto Compile(std::istream& text) -> Scenario;
+
+  void Write(std::ostream& binary, Scenario const&);
+  auto Read(std::istream& binary) -> Scenario;
+
+  // Spawn the units of the scenario, writing their references to refs.
+  void Spawn(game::Game&, Scenario const&, std::span<game::Game::UnitRef> refs);
+}
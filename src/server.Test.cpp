@@ -0,0 +1,63 @@
+#include "bot_client.h"
+#include "server.h"
+
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+
+TEST_CASE("Bots play a game hosted by the server over the loopback interface") {
+  auto server_config = net::ServerConfig{};
+  server_config.games = 2;
+  server_config.tick_rate = 50;
+  auto server = net::Server{server_config};
+  auto server_thread = std::thread{[&server] { server.run(); }};
+
+  auto bot_config = net::BotConfig{};
+  bot_config.server_port = server.port();
+  bot_config.bots = 4;
+  bot_config.games = 2;
+  bot_config.commands_per_second = 100;
+  auto swarm = net::BotSwarm{bot_config};
+  swarm.run_for(500ms);
+
+  server.stop();
+  server_thread.join();
+
+  auto const bots = swarm.stats();
+  auto const stats = server.stats();
+  REQUIRE(bots.joined == 4);
+  REQUIRE(bots.states_received > 0);
+  REQUIRE(bots.commands_sent > 0);
+  REQUIRE(stats.ticks > 0);
+  REQUIRE(stats.commands_applied > 0);
+  REQUIRE(stats.commands_rejected == 0);
+  REQUIRE(stats.commands_received <= bots.commands_sent);
+}
+
+
+TEST_CASE("The server rejects commands beyond a client's share of a tick") {
+  auto server_config = net::ServerConfig{};
+  server_config.tick_rate = 50;
+  server_config.max_pending_commands = 0;
+  auto server = net::Server{server_config};
+  auto server_thread = std::thread{[&server] { server.run(); }};
+
+  auto bot_config = net::BotConfig{};
+  bot_config.server_port = server.port();
+  bot_config.bots = 2;
+  bot_config.commands_per_second = 100;
+  auto swarm = net::BotSwarm{bot_config};
+  swarm.run_for(200ms);
+
+  server.stop();
+  server_thread.join();
+
+  auto const stats = server.stats();
+  REQUIRE(stats.commands_received > 0);
+  REQUIRE(stats.commands_applied == 0);
+  REQUIRE(stats.commands_rejected == stats.commands_received);
+}
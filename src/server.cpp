@@ -0,0 +1,463 @@
+#include "server.h"
+
+#include "game.h"
+#include "protocol.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+using namespace std::chrono;
+
+namespace net {
+  namespace {
+    constexpr auto BatchSize = std::size_t{64};
+
+    auto SystemError(char const* what) -> std::system_error {
+      return std::system_error{errno, std::generic_category(), what};
+    }
+
+    auto KeyOf(sockaddr_in const& address) -> std::uint64_t {
+      return std::uint64_t{ntohl(address.sin_addr.s_addr)} << 16
+          | ntohs(address.sin_port);
+    }
+
+    auto AddressOf(std::uint64_t key) -> sockaddr_in {
+      auto address = sockaddr_in{};
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(static_cast<std::uint32_t>(key >> 16));
+      address.sin_port = htons(static_cast<std::uint16_t>(key & 0xffff));
+      return address;
+    }
+
+    auto CommandOf(game::Command command) -> std::uint8_t {
+      return static_cast<std::uint8_t>(command);
+    }
+  }
+
+
+  // Storage for a batch of datagrams handed to recvmmsg/sendmmsg at once.
+  struct Server::Batch {
+    std::array<mmsghdr, BatchSize> messages{};
+    std::array<iovec, BatchSize> vectors{};
+    std::array<sockaddr_in, BatchSize> addresses{};
+    std::array<std::array<std::uint8_t, MaxDatagramSize>, BatchSize> buffers{};
+    std::size_t count{0};
+
+    void prepare(std::size_t index, std::size_t size) {
+      vectors[index] = {buffers[index].data(), size};
+      auto& header = messages[index].msg_hdr;
+      header = {};
+      header.msg_name = &addresses[index];
+      header.msg_namelen = sizeof(sockaddr_in);
+      header.msg_iov = &vectors[index];
+      header.msg_iovlen = 1;
+      messages[index].msg_len = 0;
+    }
+  };
+
+
+  Server::Server(ServerConfig config)
+      : config_{std::move(config)}
+      , workers_{config_.worker_threads}
+      , incoming_{std::make_unique<Batch>()}
+      , outgoing_{std::make_unique<Batch>()}
+  {
+    if (config_.games <= 0 || config_.tick_rate <= 0) {
+      throw std::invalid_argument("A server needs games and a positive tick rate!");
+    }
+    for (auto i = 0; i < config_.games; ++i) {
+      games_.push_back(std::make_unique<HostedGame>(config_.map_size));
+    }
+
+    socket_ = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (socket_ < 0) {
+      throw SystemError("socket");
+    }
+
+    auto address = sockaddr_in{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(config_.port);
+    if (::inet_pton(AF_INET, config_.address.c_str(), &address.sin_addr) != 1) {
+      ::close(socket_);
+      throw std::invalid_argument("Invalid server address: " + config_.address);
+    }
+    if (::bind(socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+      auto const error = SystemError("bind");
+      ::close(socket_);
+      throw error;
+    }
+
+    auto length = socklen_t{sizeof(address)};
+    ::getsockname(socket_, reinterpret_cast<sockaddr*>(&address), &length);
+    port_ = ntohs(address.sin_port);
+
+    epoll_ = ::epoll_create1(EPOLL_CLOEXEC);
+    timer_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    wakeup_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_ < 0 || timer_ < 0 || wakeup_ < 0) {
+      auto const error = SystemError("epoll/timerfd/eventfd");
+      close_descriptors();
+      throw error;
+    }
+
+    for (auto const fd : {socket_, timer_, wakeup_}) {
+      auto event = epoll_event{};
+      event.events = EPOLLIN;
+      event.data.fd = fd;
+      ::epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &event);
+    }
+  }
+
+
+  Server::~Server() {
+    close_descriptors();
+  }
+
+
+  void Server::close_descriptors() {
+    for (auto const fd : {socket_, epoll_, timer_, wakeup_}) {
+      if (fd >= 0) {
+        ::close(fd);
+      }
+    }
+    socket_ = epoll_ = timer_ = wakeup_ = -1;
+  }
+
+
+  void Server::stop() {
+    auto const one = std::uint64_t{1};
+    [[maybe_unused]] auto const written = ::write(wakeup_, &one, sizeof(one));
+  }
+
+
+  void Server::run() {
+    auto const period = duration_cast<nanoseconds>(seconds{1}) / config_.tick_rate;
+    auto spec = itimerspec{};
+    spec.it_value.tv_sec = spec.it_interval.tv_sec = period.count() / 1'000'000'000;
+    spec.it_value.tv_nsec = spec.it_interval.tv_nsec = period.count() % 1'000'000'000;
+    first_tick_ = Clock::now() + period;
+    expirations_ = 0;
+    ::timerfd_settime(timer_, 0, &spec, nullptr);
+
+    auto events = std::array<epoll_event, 8>{};
+    for (;;) {
+      auto const count = ::epoll_wait(epoll_, events.data(), events.size(), -1);
+      if (count < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throw SystemError("epoll_wait");
+      }
+
+      for (auto i = 0; i < count; ++i) {
+        auto const fd = events[i].data.fd;
+        if (fd == socket_) {
+          receive();
+        }
+        else if (fd == timer_) {
+          auto expirations = std::uint64_t{0};
+          if (::read(timer_, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+            tick(Clock::now(), expirations);
+          }
+        }
+        else if (fd == wakeup_) {
+          auto const disarm = itimerspec{};
+          ::timerfd_settime(timer_, 0, &disarm, nullptr);
+          return;
+        }
+      }
+    }
+  }
+
+
+  void Server::receive() {
+    auto& batch = *incoming_;
+    for (;;) {
+      for (auto i = std::size_t{0}; i < BatchSize; ++i) {
+        batch.prepare(i, MaxDatagramSize);
+      }
+
+      auto const count = ::recvmmsg(
+          socket_, batch.messages.data(), BatchSize, MSG_DONTWAIT, nullptr
+      );
+      if (count <= 0) {
+        return;
+      }
+
+      datagrams_received_ += count;
+      for (auto i = 0; i < count; ++i) {
+        handle(batch.buffers[i].data(), batch.messages[i].msg_len, &batch.addresses[i]);
+      }
+      if (static_cast<std::size_t>(count) < BatchSize) {
+        return;
+      }
+    }
+  }
+
+
+  void Server::handle(std::uint8_t const* data, std::size_t size, void const* address) {
+    auto const type = TypeOf(data, size);
+    if (!type) {
+      return;
+    }
+
+    auto const& from = *static_cast<sockaddr_in const*>(address);
+    switch (*type) {
+      case MessageType::Join: {
+        auto message = Join{};
+        if (Decode(data, size, message)) {
+          join(message, &from);
+        }
+        break;
+      }
+
+      case MessageType::Commands: {
+        auto message = CommandBatch{};
+        if (Decode(data, size, message)) {
+          enqueue(message, KeyOf(from));
+        }
+        break;
+      }
+
+      default:
+        break;
+    }
+  }
+
+
+  void Server::join(Join const& message, void const* address) {
+    if (message.game >= games_.size()) {
+      return;
+    }
+
+    auto const key = KeyOf(*static_cast<sockaddr_in const*>(address));
+    auto& hosted = *games_[message.game];
+    auto known = clients_.find(key);
+    if (known == clients_.end()) {
+      if (hosted.clients.size() >= MaxPlayersPerGame) {
+        return;
+      }
+      auto const player = static_cast<int>(hosted.clients.size());
+      hosted.clients.push_back({key, player});
+      known = clients_.emplace(key, ClientLocation{message.game, hosted.clients.size() - 1}).first;
+
+      auto position = std::uniform_real_distribution<float>{0.0f, config_.map_size};
+      game::UnitProperties const props = game::UnitProperties::Make()
+          .owner(player)
+          .hit_points(100)
+          .attack_damage(1)
+          .attack_radius(10);
+      for (auto i = 0; i < config_.units_per_client; ++i) {
+        hosted.game.spawn_unit_at({position(random_), position(random_)}, props);
+      }
+    }
+
+    auto const& client = games_[known->second.game]->clients[known->second.index];
+    auto buffer = std::array<std::uint8_t, MaxDatagramSize>{};
+    auto const size = Encode(
+        Welcome{known->second.game, static_cast<std::uint8_t>(client.player)},
+        buffer.data(), buffer.size()
+    );
+    queue_datagram(buffer.data(), size, key);
+    flush_outgoing();
+  }
+
+
+  void Server::enqueue(CommandBatch const& batch, std::uint64_t address_key) {
+    commands_received_ += batch.count;
+
+    auto const client = clients_.find(address_key);
+    if (client == clients_.end() || client->second.game != batch.game) {
+      commands_rejected_ += batch.count;
+      return;
+    }
+
+    auto& hosted = *games_[batch.game];
+    auto& sender = hosted.clients[client->second.index];
+    auto const within_map = [this](float v) {
+      return std::isfinite(v) && v >= 0.0f && v <= config_.map_size;
+    };
+
+    for (auto i = 0; i < batch.count; ++i) {
+      auto const& command = batch.commands[i];
+      auto const valid_kind = command.kind >= CommandKind::Move
+          && command.kind <= CommandKind::QueueAttack;
+      if (!valid_kind || !within_map(command.x) || !within_map(command.y)
+          || sender.pending >= config_.max_pending_commands) {
+        ++commands_rejected_;
+        continue;
+      }
+      hosted.pending.push_back({command, sender.player});
+      ++sender.pending;
+    }
+  }
+
+
+  void Server::apply_pending(HostedGame& hosted) {
+    auto& game = hosted.game;
+    for (auto const& [command, player] : hosted.pending) {
+      auto const unit = game::Game::UnitRef{command.unit};
+      auto const target = game::Game::UnitRef{command.target};
+      if (!game.contains(unit) || game.unit(unit).owner() != player) {
+        ++commands_rejected_;
+        continue;
+      }
+
+      auto const attacking = command.kind == CommandKind::Attack
+          || command.kind == CommandKind::QueueAttack;
+      if (attacking && !game.contains(target)) {
+        ++commands_rejected_;
+        continue;
+      }
+
+      switch (command.kind) {
+        case CommandKind::Move: game.move(unit, {command.x, command.y}); break;
+        case CommandKind::QueueMove: game.queue_move(unit, {command.x, command.y}); break;
+        case CommandKind::Attack: game.attack(unit, target); break;
+        case CommandKind::QueueAttack: game.queue_attack(unit, target); break;
+      }
+      ++commands_applied_;
+    }
+    hosted.pending.clear();
+    for (auto& client : hosted.clients) {
+      client.pending = 0;
+    }
+  }
+
+
+  void Server::tick(Clock::time_point now, std::uint64_t expirations) {
+    expirations_ += expirations;
+    overruns_ += expirations - 1;
+
+    auto const period = duration_cast<Clock::duration>(seconds{1}) / config_.tick_rate;
+    auto const scheduled = first_tick_ + (expirations_ - 1) * period;
+    auto const jitter = std::abs(duration_cast<microseconds>(now - scheduled).count());
+    jitter_total_us_ += jitter;
+    if (jitter > max_jitter_us_) {
+      max_jitter_us_ = jitter;
+    }
+
+    for (auto& hosted : games_) {
+      apply_pending(*hosted);
+    }
+
+    workers_.run(games_.size(), [this](std::size_t index) {
+      auto& hosted = *games_[index];
+      hosted.game.update();
+      ++hosted.tick;
+    });
+
+    for (auto index = std::size_t{0}; index < games_.size(); ++index) {
+      broadcast(*games_[index], static_cast<std::uint32_t>(index));
+    }
+    flush_outgoing();
+
+    ++ticks_;
+    mean_jitter_us_ = jitter_total_us_ / ticks_;
+  }
+
+
+  void Server::broadcast(HostedGame& hosted, std::uint32_t game_id) {
+    if (hosted.clients.empty()) {
+      return;
+    }
+
+    auto const view = hosted.game.unit_states();
+    auto state = State{};
+    state.game = game_id;
+    state.tick = hosted.tick;
+    auto buffer = std::array<std::uint8_t, MaxDatagramSize>{};
+
+    auto const send = [&] {
+      auto const size = Encode(state, buffer.data(), buffer.size());
+      for (auto const& client : hosted.clients) {
+        queue_datagram(buffer.data(), size, client.address_key);
+      }
+      state.count = 0;
+    };
+
+    for (auto const& unit : *view) {
+      state.units[state.count++] = {
+        unit.ref.id,
+        static_cast<std::uint8_t>(unit.owner),
+        unit.location.x,
+        unit.location.y,
+        unit.hit_points,
+        CommandOf(unit.command),
+      };
+      if (state.count == State::Capacity) {
+        send();
+      }
+    }
+    if (state.count > 0 || view->empty()) {
+      send();
+    }
+  }
+
+
+  void Server::queue_datagram(
+      std::uint8_t const* data, std::size_t size, std::uint64_t address_key
+  ) {
+    if (size == 0) {
+      return;
+    }
+
+    auto& batch = *outgoing_;
+    if (batch.count == BatchSize) {
+      flush_outgoing();
+    }
+    auto const index = batch.count++;
+    std::memcpy(batch.buffers[index].data(), data, size);
+    batch.prepare(index, size);
+    batch.addresses[index] = AddressOf(address_key);
+  }
+
+
+  void Server::flush_outgoing() {
+    auto& batch = *outgoing_;
+    auto sent = std::size_t{0};
+    while (sent < batch.count) {
+      auto const count = ::sendmmsg(
+          socket_, batch.messages.data() + sent, batch.count - sent, MSG_DONTWAIT
+      );
+      if (count <= 0) {
+        // The socket buffer is full; drop the rest of this batch, the next
+        // tick brings fresher state anyway.
+        break;
+      }
+      sent += count;
+    }
+    datagrams_sent_ += sent;
+    batch.count = 0;
+  }
+
+
+  auto Server::stats() const -> ServerStats {
+    return {
+      datagrams_received_.load(),
+      datagrams_sent_.load(),
+      commands_received_.load(),
+      commands_rejected_.load(),
+      commands_applied_.load(),
+      ticks_.load(),
+      overruns_.load(),
+      microseconds{max_jitter_us_.load()},
+      microseconds{mean_jitter_us_.load()},
+    };
+  }
+}
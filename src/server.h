@@ -0,0 +1,141 @@
+#pragma once
+
+#include "game.h"
+#include "protocol.h"
+#include "thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace net {
+  struct ServerConfig {
+    std::string address{"127.0.0.1"};
+    std::uint16_t port{0};
+    int games{1};
+    int tick_rate{20};
+    float map_size{1000.0f};
+    int units_per_client{4};
+    std::size_t worker_threads{0};
+    // Commands queued per client until the next tick; the excess is rejected.
+    std::size_t max_pending_commands{4 * CommandBatch::Capacity};
+  };
+
+
+  struct ServerStats {
+    std::uint64_t datagrams_received;
+    std::uint64_t datagrams_sent;
+    std::uint64_t commands_received;
+    std::uint64_t commands_rejected;
+    std::uint64_t commands_applied;
+    std::uint64_t ticks;
+    std::uint64_t overruns;
+    std::chrono::microseconds max_tick_jitter;
+    std::chrono::microseconds mean_tick_jitter;
+  };
+
+
+  // Headless authoritative server hosting a number of games over UDP.
+  //
+  // A single event loop thread waits on the socket and the tick timer with
+  // epoll. Datagrams are read in batches with recvmmsg; commands are checked
+  // and queued per game, and applied at the next tick. All games are then
+  // updated on the worker pool and their states are sent to every client of
+  // the game in batches with sendmmsg.
+  class Server {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+  private:
+    struct Client {
+      std::uint64_t address_key;
+      int player;
+      std::size_t pending{0};
+    };
+
+    // Players are sent as one byte.
+    static constexpr auto MaxPlayersPerGame = std::size_t{255};
+
+    struct PendingCommand {
+      Command command;
+      int player;
+    };
+
+    struct HostedGame {
+      game::Game game;
+      std::vector<Client> clients;
+      std::vector<PendingCommand> pending;
+      std::uint32_t tick{0};
+
+      explicit HostedGame(float map_size) : game{map_size, map_size} {}
+    };
+
+    struct ClientLocation {
+      std::uint32_t game;
+      std::size_t index;
+    };
+
+    struct Batch;
+
+    ServerConfig const config_;
+    int socket_{-1};
+    int epoll_{-1};
+    int timer_{-1};
+    int wakeup_{-1};
+    std::uint16_t port_{0};
+
+    std::vector<std::unique_ptr<HostedGame>> games_;
+    std::unordered_map<std::uint64_t, ClientLocation> clients_;
+    concurrency::ThreadPool workers_;
+    std::unique_ptr<Batch> incoming_;
+    std::unique_ptr<Batch> outgoing_;
+
+    std::minstd_rand random_;
+    Clock::time_point first_tick_;
+    std::uint64_t expirations_{0};
+    std::uint64_t jitter_total_us_{0};
+
+    std::atomic<std::uint64_t> datagrams_received_{0};
+    std::atomic<std::uint64_t> datagrams_sent_{0};
+    std::atomic<std::uint64_t> commands_received_{0};
+    std::atomic<std::uint64_t> commands_rejected_{0};
+    std::atomic<std::uint64_t> commands_applied_{0};
+    std::atomic<std::uint64_t> ticks_{0};
+    std::atomic<std::uint64_t> overruns_{0};
+    std::atomic<std::int64_t> max_jitter_us_{0};
+    std::atomic<std::int64_t> mean_jitter_us_{0};
+
+    void close_descriptors();
+    void receive();
+    void handle(std::uint8_t const* data, std::size_t size, void const* address);
+    void join(Join const&, void const* address);
+    void enqueue(CommandBatch const&, std::uint64_t address_key);
+
+    void tick(Clock::time_point now, std::uint64_t expirations);
+    void apply_pending(HostedGame&);
+    void broadcast(HostedGame&, std::uint32_t game_id);
+    void queue_datagram(std::uint8_t const* data, std::size_t size, std::uint64_t address_key);
+    void flush_outgoing();
+
+  public:
+    explicit Server(ServerConfig);
+    ~Server();
+
+    Server(Server const&) = delete;
+    auto operator=(Server const&) -> Server& = delete;
+
+    auto port() const -> std::uint16_t { return port_; }
+
+    // Serve until stop() is called, from any thread.
+    void run();
+    void stop();
+
+    auto stats() const -> ServerStats;
+  };
+}
@@ -0,0 +1,72 @@
+#include "small_queue.h"
+
+#include <catch2/catch.hpp>
+
+#include <memory_resource>
+
+using container::SmallQueue;
+
+
+TEST_CASE("A small queue is first in, first out") {
+  auto queue = SmallQueue<int, 2>{};
+  REQUIRE(queue.empty());
+
+  queue.push_back(1);
+  queue.push_back(2);
+  REQUIRE(queue.size() == 2);
+  REQUIRE(queue.front() == 1);
+
+  queue.pop_front();
+  REQUIRE(queue.front() == 2);
+
+  queue.push_back(3);
+  queue.pop_front();
+  REQUIRE(queue.front() == 3);
+}
+
+
+TEST_CASE("A small queue keeps its first elements inline") {
+  auto counting = std::pmr::monotonic_buffer_resource{std::pmr::null_memory_resource()};
+  auto queue = SmallQueue<int, 3>{&counting};
+
+  SECTION("without needing the memory resource") {
+    for (auto i = 0; i < 3; ++i) {
+      REQUIRE_NOTHROW(queue.push_back(i));
+    }
+    REQUIRE_FALSE(queue.spilled());
+  }
+
+  SECTION("and asks the memory resource for anything beyond that") {
+    for (auto i = 0; i < 3; ++i) {
+      queue.push_back(i);
+    }
+    REQUIRE_THROWS_AS(queue.push_back(3), std::bad_alloc);
+  }
+}
+
+
+TEST_CASE("A spilled small queue preserves the order of its elements") {
+  auto pool = std::pmr::unsynchronized_pool_resource{};
+  auto queue = SmallQueue<int, 2>{&pool};
+  for (auto i = 0; i < 7; ++i) {
+    queue.push_back(i);
+  }
+  REQUIRE(queue.spilled());
+  REQUIRE(queue.size() == 7);
+
+  for (auto i = 0; i < 7; ++i) {
+    REQUIRE(queue.front() == i);
+    queue.pop_front();
+  }
+  REQUIRE(queue.empty());
+  REQUIRE_FALSE(queue.spilled());
+
+  SECTION("and can be cleared") {
+    queue.push_back(1);
+    queue.push_back(2);
+    queue.push_back(3);
+    queue.clear();
+    REQUIRE(queue.empty());
+    REQUIRE(queue.size() == 0);
+  }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+namespace container {
+  // FIFO queue keeping its first N elements inline, without touching the
+  // heap. Anything beyond that spills into a vector allocated from the given
+  // memory resource, so a pool shared between many queues can serve the
+  // occasional long queue. The spill storage is drained from the front and
+  // reused, so after warm-up push/pop cycles do not allocate.
+  template<typename T, std::size_t N>
+  class SmallQueue {
+    static_assert(N > 0, "SmallQueue needs at least one inline slot");
+
+    std::array<T, N> inline_{};
+    std::size_t head_{0};
+    std::size_t inline_size_{0};
+
+    std::pmr::vector<T> spill_;
+    std::size_t spill_head_{0};
+
+    void push_inline(T value) {
+      inline_[(head_ + inline_size_) % N] = std::move(value);
+      ++inline_size_;
+    }
+
+  public:
+    static constexpr auto InlineCapacity = N;
+
+    SmallQueue() = default;
+    explicit SmallQueue(std::pmr::memory_resource* resource)
+        : spill_{resource} {}
+
+    auto empty() const noexcept -> bool { return inline_size_ == 0; }
+    auto size() const noexcept -> std::size_t {
+      return inline_size_ + spill_.size() - spill_head_;
+    }
+    auto spilled() const noexcept -> bool { return spill_head_ < spill_.size(); }
+
+    auto front() -> T& { return inline_[head_]; }
+    auto front() const -> T const& { return inline_[head_]; }
+
+    void push_back(T value) {
+      if (inline_size_ < N && !spilled()) {
+        push_inline(std::move(value));
+      }
+      else {
+        spill_.push_back(std::move(value));
+      }
+    }
+
+    void pop_front() {
+      inline_[head_] = T{};
+      head_ = (head_ + 1) % N;
+      --inline_size_;
+
+      if (spilled()) {
+        push_inline(std::move(spill_[spill_head_++]));
+        if (spill_head_ == spill_.size()) {
+          spill_.clear();
+          spill_head_ = 0;
+        }
+      }
+    }
+
+    void clear() {
+      while (inline_size_ > 0) {
+        inline_[head_] = T{};
+        head_ = (head_ + 1) % N;
+        --inline_size_;
+      }
+      head_ = 0;
+      spill_.clear();
+      spill_head_ = 0;
+    }
+  };
+}
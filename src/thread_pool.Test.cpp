@@ -0,0 +1,46 @@
+#include "thread_pool.h"
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+using concurrency::ThreadPool;
+
+
+TEST_CASE("A thread pool runs every job of a batch exactly once") {
+  auto const thread_count = GENERATE(0, 1, 4);
+  auto pool = ThreadPool{static_cast<std::size_t>(thread_count)};
+
+  auto runs = std::vector<std::atomic<int>>(100);
+  for (auto batch = 0; batch < 10; ++batch) {
+    pool.run(runs.size(), [&](std::size_t index) { ++runs[index]; });
+  }
+
+  for (auto const& count : runs) {
+    REQUIRE(count == 10);
+  }
+}
+
+
+TEST_CASE("A thread pool passes on the failure of a job") {
+  auto pool = ThreadPool{2};
+  auto completed = std::atomic<int>{0};
+
+  REQUIRE_THROWS_AS(
+      pool.run(8, [&](std::size_t index) {
+        if (index == 3) {
+          throw std::runtime_error("failed");
+        }
+        ++completed;
+      }),
+      std::runtime_error
+  );
+  REQUIRE(completed == 7);
+
+  SECTION("and remains usable afterwards") {
+    REQUIRE_NOTHROW(pool.run(4, [](std::size_t) {}));
+  }
+}
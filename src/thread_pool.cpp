@@ -0,0 +1,92 @@
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <utility>
+
+namespace concurrency {
+  ThreadPool::ThreadPool(std::size_t thread_count) {
+    workers_.reserve(thread_count);
+    for (auto i = std::size_t{0}; i < thread_count; ++i) {
+      workers_.emplace_back([this] { work(); });
+    }
+  }
+
+
+  ThreadPool::~ThreadPool() {
+    {
+      auto lock = std::lock_guard{mutex_};
+      stopping_ = true;
+    }
+    work_available_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+
+  void ThreadPool::drain(std::unique_lock<std::mutex>& lock) {
+    while (next_job_ < job_count_) {
+      auto const index = next_job_++;
+      auto const& job = *job_;
+      lock.unlock();
+      auto error = std::exception_ptr{};
+      try {
+        job(index);
+      }
+      catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+      if (error && !error_) {
+        error_ = error;
+      }
+      if (--pending_jobs_ == 0) {
+        work_done_.notify_all();
+      }
+    }
+  }
+
+
+  void ThreadPool::work() {
+    auto lock = std::unique_lock{mutex_};
+    auto seen_generation = generation_;
+    for (;;) {
+      work_available_.wait(lock, [&] {
+        return stopping_ || generation_ != seen_generation;
+      });
+      if (stopping_) {
+        return;
+      }
+      seen_generation = generation_;
+      drain(lock);
+    }
+  }
+
+
+  void ThreadPool::run(
+      std::size_t job_count, std::function<void(std::size_t)> const& job
+  ) {
+    if (job_count == 0) {
+      return;
+    }
+
+    auto lock = std::unique_lock{mutex_};
+    job_ = &job;
+    job_count_ = job_count;
+    next_job_ = 0;
+    pending_jobs_ = job_count;
+    ++generation_;
+    work_available_.notify_all();
+
+    drain(lock);
+    work_done_.wait(lock, [this] { return pending_jobs_ == 0; });
+    job_ = nullptr;
+
+    if (error_) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+  }
+}
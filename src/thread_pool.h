@@ -0,0 +1,48 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace concurrency {
+  // A fixed set of worker threads running one batch of indexed jobs at a
+  // time. The calling thread takes part in the work and run() returns once
+  // every job of the batch is done.
+  class ThreadPool {
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;
+    std::condition_variable work_available_;
+    std::condition_variable work_done_;
+
+    std::function<void(std::size_t)> const* job_{nullptr};
+    std::size_t job_count_{0};
+    std::size_t next_job_{0};
+    std::size_t pending_jobs_{0};
+    std::size_t generation_{0};
+    bool stopping_{false};
+    std::exception_ptr error_;
+
+    void work();
+    void drain(std::unique_lock<std::mutex>&);
+
+  public:
+    // A pool of zero threads runs everything on the caller.
+    explicit ThreadPool(std::size_t thread_count);
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const&) = delete;
+    auto operator=(ThreadPool const&) -> ThreadPool& = delete;
+
+    auto thread_count() const -> std::size_t { return workers_.size(); }
+
+    // Call job(i) for every i in [0, job_count), spread over the workers.
+    // If any of the jobs throws, the first exception is rethrown here once
+    // the whole batch has finished.
+    void run(std::size_t job_count, std::function<void(std::size_t)> const& job);
+  };
+}
@@ -0,0 +1,86 @@
+#include "triple_buffer.h"
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using container::TripleBuffer;
+
+
+TEST_CASE("A triple buffer shows readers the latest published value") {
+  auto buffer = TripleBuffer<int>{};
+  REQUIRE(*buffer.read() == 0);
+
+  *buffer.acquire_write() = 1;
+  REQUIRE(*buffer.read() == 0);
+
+  buffer.publish();
+  REQUIRE(*buffer.read() == 1);
+
+  SECTION("and a held view is not affected by later publications") {
+    auto const view = buffer.read();
+    *buffer.acquire_write() = 2;
+    buffer.publish();
+    REQUIRE(*view == 1);
+    REQUIRE(*buffer.read() == 2);
+  }
+}
+
+
+TEST_CASE("A triple buffer never hands the writer a slot being read") {
+  auto buffer = TripleBuffer<int>{};
+  *buffer.acquire_write() = 1;
+  buffer.publish();
+  auto const first = buffer.read();
+
+  *buffer.acquire_write() = 2;
+  buffer.publish();
+  auto const second = buffer.read();
+
+  *buffer.acquire_write() = 3;
+  buffer.publish();
+
+  REQUIRE(buffer.acquire_write() == nullptr);
+  buffer.publish();
+  REQUIRE(*first == 1);
+  REQUIRE(*second == 2);
+  REQUIRE(*buffer.read() == 3);
+}
+
+
+TEST_CASE("A triple buffer can be read concurrently with writing") {
+  struct Pair { int a; int b; };
+  auto buffer = TripleBuffer<Pair>{};
+  auto done = std::atomic<bool>{false};
+  auto torn_reads = std::atomic<int>{0};
+
+  auto readers = std::vector<std::thread>{};
+  for (auto i = 0; i < 3; ++i) {
+    readers.emplace_back([&] {
+      auto last = 0;
+      while (!done) {
+        auto const view = buffer.read();
+        if (view->a != view->b || view->a < last) {
+          ++torn_reads;
+        }
+        last = view->a;
+      }
+    });
+  }
+
+  for (auto i = 1; i <= 20000; ++i) {
+    if (auto* slot = buffer.acquire_write()) {
+      slot->a = i;
+      slot->b = i;
+      buffer.publish();
+    }
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  REQUIRE(torn_reads == 0);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <utility>
+
+namespace container {
+  // Hands immutable snapshots from a single writer to any number of readers
+  // without locks. The writer fills a slot nobody is reading and publishes
+  // it; readers pin the most recently published slot for as long as they
+  // hold a ReadHandle.
+  //
+  // Neither side ever waits for the other. If readers keep both non-latest
+  // slots pinned, acquire_write() returns nullptr and the writer skips that
+  // publication; readers then simply keep seeing the previous snapshot.
+  template<typename T>
+  class TripleBuffer {
+    static constexpr auto SlotCount = 3;
+
+    struct alignas(64) ReaderCount {
+      std::atomic<int> value{0};
+    };
+
+    std::array<T, SlotCount> slots_{};
+    mutable std::array<ReaderCount, SlotCount> readers_{};
+    std::atomic<int> latest_{0};
+    int writing_{-1};
+
+  public:
+    TripleBuffer() = default;
+
+    // Construct every slot from the same arguments, e.g. an allocator.
+    template<typename Arg, typename... Args>
+    explicit TripleBuffer(Arg const& arg, Args const&... args)
+        : slots_{T(arg, args...), T(arg, args...), T(arg, args...)} {}
+
+    class ReadHandle {
+      TripleBuffer const* buffer_;
+      int slot_;
+
+    public:
+      ReadHandle(TripleBuffer const* buffer, int slot)
+          : buffer_{buffer}, slot_{slot} {}
+      ReadHandle(ReadHandle&& rhs) noexcept
+          : buffer_{std::exchange(rhs.buffer_, nullptr)}, slot_{rhs.slot_} {}
+      ReadHandle(ReadHandle const&) = delete;
+      auto operator=(ReadHandle const&) -> ReadHandle& = delete;
+      auto operator=(ReadHandle&&) -> ReadHandle& = delete;
+
+      ~ReadHandle() {
+        if (buffer_) {
+          buffer_->readers_[slot_].value.fetch_sub(1);
+        }
+      }
+
+      auto operator*() const -> T const& { return buffer_->slots_[slot_]; }
+      auto operator->() const -> T const* { return &buffer_->slots_[slot_]; }
+    };
+
+
+    // Writer side: a slot to fill, or nullptr if readers hold all of them.
+    auto acquire_write() -> T* {
+      auto const latest = latest_.load();
+      for (auto slot = 0; slot < SlotCount; ++slot) {
+        if (slot != latest && readers_[slot].value.load() == 0) {
+          writing_ = slot;
+          return &slots_[slot];
+        }
+      }
+      return nullptr;
+    }
+
+    // Writer side: make the slot returned by acquire_write() the latest.
+    void publish() {
+      if (writing_ >= 0) {
+        latest_.store(std::exchange(writing_, -1));
+      }
+    }
+
+    // Reader side: pin the latest published snapshot.
+    auto read() const -> ReadHandle {
+      for (;;) {
+        auto const slot = latest_.load();
+        readers_[slot].value.fetch_add(1);
+        if (latest_.load() == slot) {
+          return ReadHandle{this, slot};
+        }
+        readers_[slot].value.fetch_sub(1);
+      }
+    }
+  };
+}
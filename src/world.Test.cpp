@@ -0,0 +1,189 @@
+#include "world.h"
+
+#include "game.h"
+#include "geometry.h"
+
+#include <catch2/catch.hpp>
+
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace game;
+using geometry::Location;
+using geometry::Size;
+
+
+namespace {
+  void UpdateTimes(World& world, int times) {
+    for (int i = times; i > 0; --i) {
+      world.update();
+    }
+  }
+
+  struct CasualtyCounter : public Game::GameEvents {
+    int damages{0};
+    int casualties{0};
+    int commands_finished{0};
+    void damage(Game::UnitRef) override { ++damages; }
+    void casualty(Game::UnitRef) override { ++casualties; }
+    void command_finished(Game::UnitRef) override { ++commands_finished; }
+  };
+}
+
+
+TEST_CASE("A world is split into a grid of regions") {
+  auto world = World{Size{400, 200}, 4, 2, 2, 10};
+  REQUIRE(world.region_count() == 8);
+
+  SECTION("each owning the units spawned in it") {
+    REQUIRE(world.region_of(world.spawn_unit_at({10, 10}, {})) == 0);
+    REQUIRE(world.region_of(world.spawn_unit_at({150, 10}, {})) == 1);
+    REQUIRE(world.region_of(world.spawn_unit_at({350, 150}, {})) == 7);
+  }
+
+  SECTION("which does not extend beyond the map") {
+    REQUIRE_THROWS_AS(world.spawn_unit_at({500, 10}, {}), InvalidPosition);
+  }
+
+  SECTION("sharing a halo of limited width along their borders") {
+    auto const infinite = std::numeric_limits<float>::infinity();
+    REQUIRE_THROWS_AS(World(Size{400, 200}, 4, 2, 2, infinite), std::invalid_argument);
+  }
+}
+
+
+TEST_CASE("Units moving across a region border are handed over") {
+  auto world = World{Size{200, 100}, 2, 1, 2, 10};
+  auto const unit = world.spawn_unit_at({90, 50}, {});
+  world.move(unit, {105, 50});
+  world.queue_move(unit, {105, 60});
+
+  UpdateTimes(world, 15);
+  REQUIRE(world.region_of(unit) == 1);
+  REQUIRE(world.position_of(unit) == Location{105, 50});
+
+  SECTION("with their remaining commands") {
+    REQUIRE(world.active_command_for(unit) == Command::Move);
+    UpdateTimes(world, 10);
+    REQUIRE(world.position_of(unit) == Location{105, 60});
+    REQUIRE(world.active_command_for(unit) == Command::None);
+  }
+
+  SECTION("and report their finished commands to the world's listener") {
+    auto events = std::make_shared<CasualtyCounter>();
+    world.listen(events);
+    UpdateTimes(world, 10);
+    REQUIRE(events->commands_finished == 1);
+  }
+}
+
+
+TEST_CASE("Units can attack across region borders") {
+  auto world = World{Size{200, 100}, 2, 1, 2, 30};
+  auto events = std::make_shared<CasualtyCounter>();
+  world.listen(events);
+
+  UnitProperties const victim_props = UnitProperties::Make().hit_points(3);
+  UnitProperties const attacker_props =
+      UnitProperties::Make()
+          .attack_damage(1)
+          .attack_radius(30)
+  ;
+  auto const victim = world.spawn_unit_at({110, 50}, victim_props);
+  auto const attacker = world.spawn_unit_at({60, 50}, attacker_props);
+  world.attack(attacker, victim);
+
+  UpdateTimes(world, 21);
+  REQUIRE(world.region_of(attacker) == 0);
+  REQUIRE(world.position_of(attacker) == Location{80, 50});
+  REQUIRE(world.unit(victim).hit_points() == 2);
+
+  UpdateTimes(world, 3);
+  REQUIRE(events->damages == 2);
+  REQUIRE(events->casualties == 1);
+  REQUIRE_THROWS(world.region_of(victim));
+
+  UpdateTimes(world, 1);
+  REQUIRE(world.active_command_for(attacker) == Command::None);
+}
+
+
+TEST_CASE("Units chase targets beyond the halo of their region") {
+  auto world = World{Size{200, 100}, 2, 1, 2, 10};
+  auto events = std::make_shared<CasualtyCounter>();
+  world.listen(events);
+
+  UnitProperties const attacker_props = UnitProperties::Make().attack_radius(5);
+  UnitProperties const target_props = UnitProperties::Make().hit_points(1);
+  auto const target = world.spawn_unit_at({150, 50}, target_props);
+  auto const attacker = world.spawn_unit_at({10, 50}, attacker_props);
+  world.attack(attacker, target);
+
+  UpdateTimes(world, 3);
+  REQUIRE(world.active_command_for(attacker) == Command::Attack);
+  REQUIRE(world.position_of(attacker) == Location{13, 50});
+
+  SECTION("until they are within reach") {
+    UpdateTimes(world, 132);
+    REQUIRE(world.region_of(attacker) == 1);
+    REQUIRE(world.position_of(attacker) == Location{145, 50});
+    REQUIRE(world.active_command_for(attacker) == Command::Attack);
+  }
+
+  SECTION("and give up on them once they are gone") {
+    UnitProperties const killer_props = UnitProperties::Make().attack_damage(1);
+    auto const killer = world.spawn_unit_at({160, 50}, killer_props);
+    world.attack(killer, target);
+
+    UpdateTimes(world, 1);
+    REQUIRE(events->casualties == 1);
+    REQUIRE(world.active_command_for(attacker) == Command::Attack);
+
+    UpdateTimes(world, 1);
+    REQUIRE(world.active_command_for(attacker) == Command::None);
+    REQUIRE(events->commands_finished == 2);
+  }
+}
+
+
+TEST_CASE("A world simulates the same as a single game") {
+  auto world = World{Size{256, 256}, 4, 4, 3, 16};
+  auto game = Game{256, 256};
+
+  auto world_units = std::vector<Game::UnitRef>{};
+  auto game_units = std::vector<Game::UnitRef>{};
+  for (auto i = 0; i < 64; ++i) {
+    auto const from = Location{4.0f * i, 255.0f - 4.0f * i};
+    auto const to = Location{255.0f - 3.0f * i, 2.0f * i};
+    world_units.push_back(world.spawn_unit_at(from, {}));
+    game_units.push_back(game.spawn_unit_at(from, {}));
+    world.move(world_units.back(), to);
+    game.move(game_units.back(), to);
+  }
+
+  // Chasers attacking idle targets across several regions, further away
+  // than the halo reaches.
+  UnitProperties const chaser = UnitProperties::Make().attack_radius(2).attack_damage(1);
+  for (auto i = 0; i < 16; ++i) {
+    auto const target_at = Location{8.0f + 16.0f * i, 8.0f};
+    auto const chaser_at = Location{248.0f - 15.0f * i, 200.0f - 10.0f * i};
+    auto const world_target = world.spawn_unit_at(target_at, {});
+    auto const game_target = game.spawn_unit_at(target_at, {});
+    world_units.push_back(world.spawn_unit_at(chaser_at, chaser));
+    game_units.push_back(game.spawn_unit_at(chaser_at, chaser));
+    world.attack(world_units.back(), world_target);
+    game.attack(game_units.back(), game_target);
+  }
+
+  for (auto tick = 0; tick < 300; ++tick) {
+    world.update();
+    game.update();
+  }
+
+  for (auto i = 0u; i < world_units.size(); ++i) {
+    REQUIRE(world.position_of(world_units[i]) == game.position_of(game_units[i]));
+    REQUIRE(world.active_command_for(world_units[i]) == game.active_command_for(game_units[i]));
+  }
+}
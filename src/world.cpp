@@ -0,0 +1,252 @@
+#include "world.h"
+
+#include "game.h"
+#include "geometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+using namespace geometry;
+
+namespace game {
+  namespace {
+    // Collects a region's events during its tick, which runs on a worker, to
+    // pass them on from the thread driving the world.
+    struct EventRecorder : public Game::GameEvents {
+      enum class Kind { Damage, Casualty, CommandFinished };
+      struct Event {
+        Kind kind;
+        Game::UnitRef ref;
+      };
+      std::vector<Event> events;
+
+      void damage(Game::UnitRef ref) override { events.push_back({Kind::Damage, ref}); }
+      void casualty(Game::UnitRef ref) override { events.push_back({Kind::Casualty, ref}); }
+      void command_finished(Game::UnitRef ref) override {
+        events.push_back({Kind::CommandFinished, ref});
+      }
+    };
+  }
+
+
+  struct World::Region {
+    Rectangle const area;
+    Game game;
+    std::shared_ptr<EventRecorder> const events{std::make_shared<EventRecorder>()};
+    std::vector<std::size_t> neighbours;
+    std::vector<Game::DetachedUnit> leaving;
+
+    Region(Rectangle a, Size map) : area{a}, game{map.width, map.height} {
+      game.listen(events);
+      game.keep_attacks_on_unseen_targets(true);
+    }
+  };
+
+
+  World::World(
+      Size map_dimensions,
+      int columns, int rows,
+      std::size_t worker_threads,
+      float halo_width
+  )
+      : map_dimensions_{map_dimensions}
+      , columns_{columns}
+      , rows_{rows}
+      , halo_width_{halo_width}
+      , workers_{worker_threads}
+  {
+    if (columns <= 0 || rows <= 0) {
+      throw std::invalid_argument("A world needs at least one region!");
+    }
+    if (!std::isfinite(halo_width) || halo_width < 0.0f) {
+      throw std::invalid_argument("The halo width must be finite and not negative!");
+    }
+
+    auto const width = map_dimensions.width / columns;
+    auto const height = map_dimensions.height / rows;
+    for (auto row = 0; row < rows; ++row) {
+      for (auto column = 0; column < columns; ++column) {
+        auto const area = Rectangle{
+            Location{column * width, row * height},
+            Size{width, height}
+        };
+        regions_.push_back(std::make_unique<Region>(area, map_dimensions));
+      }
+    }
+
+    for (auto row = 0; row < rows; ++row) {
+      for (auto column = 0; column < columns; ++column) {
+        auto& neighbours = regions_[row * columns + column]->neighbours;
+        for (auto r = std::max(row - 1, 0); r <= std::min(row + 1, rows - 1); ++r) {
+          for (auto c = std::max(column - 1, 0); c <= std::min(column + 1, columns - 1); ++c) {
+            if (r != row || c != column) {
+              neighbours.push_back(r * columns + c);
+            }
+          }
+        }
+      }
+    }
+  }
+
+
+  World::~World() = default;
+
+
+  auto World::region_index_at(Location loc) const -> std::size_t {
+    auto const column = static_cast<int>(loc.x / (map_dimensions_.width / columns_));
+    auto const row = static_cast<int>(loc.y / (map_dimensions_.height / rows_));
+    return std::clamp(row, 0, rows_ - 1) * columns_
+        + std::clamp(column, 0, columns_ - 1);
+  }
+
+
+  auto World::region_of(UnitRef ref) const -> std::size_t {
+    return owners_.at(ref.id);
+  }
+
+
+  auto World::game_of(UnitRef ref) const -> Game& {
+    return regions_[region_of(ref)]->game;
+  }
+
+
+  auto World::spawn_unit_at(Location location, UnitProperties const& props) -> UnitRef {
+    if (!Contains(Rectangle{map_dimensions_}, location)) {
+      throw InvalidPosition{};
+    }
+
+    auto const index = region_index_at(location);
+    auto const ref = regions_[index]->game.spawn_unit_at(location, props);
+    owners_.emplace(ref.id, index);
+    return ref;
+  }
+
+
+  auto World::position_of(UnitRef ref) const -> Location {
+    return game_of(ref).position_of(ref);
+  }
+
+  auto World::unit(UnitRef ref) const -> UnitProperties {
+    return game_of(ref).unit(ref);
+  }
+
+  auto World::active_command_for(UnitRef ref) const -> Command {
+    return game_of(ref).active_command_for(ref);
+  }
+
+  void World::move(UnitRef ref, Location location) {
+    game_of(ref).move(ref, location);
+  }
+
+  void World::attack(UnitRef attacker, UnitRef target) {
+    game_of(attacker).attack(attacker, target);
+  }
+
+  void World::queue_move(UnitRef ref, Location location) {
+    game_of(ref).queue_move(ref, location);
+  }
+
+  void World::queue_attack(UnitRef attacker, UnitRef target) {
+    game_of(attacker).queue_attack(attacker, target);
+  }
+
+
+  void World::refresh_halo(Region& region) {
+    auto& halo = region.game.halo();
+    halo.clear();
+    auto const surroundings = ContractedBy(region.area, -halo_width_);
+    for (auto const index : region.neighbours) {
+      regions_[index]->game.append_positions_within(surroundings, halo);
+    }
+
+    // Targets chased beyond the halo come from the region owning them.
+    for (auto const& [attacker, target] : region.game.foreign_targets()) {
+      if (auto const owner = owners_.find(target.id); owner != owners_.end()) {
+        halo.push_back({target, regions_[owner->second]->game.position_of(target)});
+      }
+    }
+  }
+
+
+  void World::drop_lost_attacks() {
+    for (auto& region : regions_) {
+      auto const& targets = region->game.foreign_targets();
+      // Dropping an attack may note the attacker's next target.
+      for (auto index = std::size_t{0}; index < targets.size(); ++index) {
+        auto const [attacker, target] = targets[index];
+        if (owners_.count(target.id) == 0) {
+          region->game.drop_attack(attacker, target);
+        }
+      }
+    }
+  }
+
+
+  void World::hand_over_units() {
+    for (auto& region : regions_) {
+      for (auto& unit : region->leaving) {
+        auto const ref = unit.ref();
+        auto const index = region_index_at(unit.location());
+        regions_[index]->game.attach_unit(std::move(unit));
+        owners_[ref.id] = index;
+      }
+      region->leaving.clear();
+    }
+  }
+
+
+  void World::deliver_foreign_damage() {
+    for (auto& region : regions_) {
+      for (auto const& [target, amount] : region->game.foreign_damage()) {
+        if (auto const owner = owners_.find(target.id); owner != owners_.end()) {
+          regions_[owner->second]->game.apply_damage(target, amount);
+        }
+      }
+      region->game.clear_foreign_damage();
+    }
+  }
+
+
+  void World::dispatch_events() {
+    for (auto& region : regions_) {
+      for (auto const& [kind, ref] : region->events->events) {
+        if (kind == EventRecorder::Kind::Casualty) {
+          owners_.erase(ref.id);
+        }
+
+        if (!listener_) {
+          continue;
+        }
+        switch (kind) {
+          case EventRecorder::Kind::Damage: listener_->damage(ref); break;
+          case EventRecorder::Kind::Casualty: listener_->casualty(ref); break;
+          case EventRecorder::Kind::CommandFinished: listener_->command_finished(ref); break;
+        }
+      }
+      region->events->events.clear();
+    }
+  }
+
+
+  void World::update() {
+    drop_lost_attacks();
+    workers_.run(regions_.size(), [this](std::size_t index) {
+      auto& region = *regions_[index];
+      refresh_halo(region);
+    });
+
+    workers_.run(regions_.size(), [this](std::size_t index) {
+      auto& region = *regions_[index];
+      region.game.update();
+      region.game.detach_units_outside(region.area, region.leaving);
+    });
+
+    hand_over_units();
+    deliver_foreign_damage();
+    dispatch_events();
+  }
+}
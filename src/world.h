@@ -0,0 +1,81 @@
+#pragma once
+
+#include "game.h"
+#include "geometry.h"
+#include "thread_pool.h"
+
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace game {
+  // A map split into a grid of regions, each simulated by its own Game, with
+  // the regions of a tick updated in parallel.
+  //
+  // Units leaving their region are handed over to the region they moved into
+  // at the end of the tick. Units may chase and attack units of other
+  // regions through a halo: a read-only copy of the positions of neighbouring
+  // units within halo_width of the region's border, refreshed before every
+  // tick, along with the positions of the targets the region's units chase
+  // from further away. The halo width should be about the largest attack
+  // radius; it has to be finite, as a wider halo only costs more copying per
+  // tick. Damage across borders is applied by the owning region at the end
+  // of the tick in which it was dealt, and attacks on units which are gone
+  // are dropped before the next tick.
+  class World {
+  public:
+    using UnitRef = Game::UnitRef;
+
+  private:
+    struct Region;
+
+    geometry::Size const map_dimensions_;
+    int const columns_;
+    int const rows_;
+    float const halo_width_;
+
+    std::vector<std::unique_ptr<Region>> regions_;
+    std::unordered_map<int, std::size_t> owners_;
+    concurrency::ThreadPool workers_;
+
+    Game::GameEventsPtr listener_;
+
+    auto region_index_at(geometry::Location) const -> std::size_t;
+    auto game_of(UnitRef) const -> Game&;
+
+    void refresh_halo(Region&);
+    void drop_lost_attacks();
+    void hand_over_units();
+    void deliver_foreign_damage();
+    void dispatch_events();
+
+  public:
+    World(
+        geometry::Size map_dimensions,
+        int columns, int rows,
+        std::size_t worker_threads,
+        float halo_width
+    );
+    ~World();
+
+    auto spawn_unit_at(geometry::Location, UnitProperties const&) -> UnitRef;
+    auto position_of(UnitRef) const -> geometry::Location;
+    auto unit(UnitRef) const -> UnitProperties;
+    auto active_command_for(UnitRef) const -> Command;
+
+    void move(UnitRef, geometry::Location);
+    void attack(UnitRef, UnitRef);
+    void queue_move(UnitRef, geometry::Location);
+    void queue_attack(UnitRef, UnitRef);
+
+    void update();
+
+    // Events are delivered on the thread calling update(), after all regions
+    // have finished the tick.
+    void listen(Game::GameEventsPtr l) { listener_ = l; }
+
+    auto region_count() const -> std::size_t { return regions_.size(); }
+    auto region_of(UnitRef) const -> std::size_t;
+  };
+}